@@ -0,0 +1,172 @@
+// Benchmark: serializing a /bills page. Compares building a DOM per row and dumping it (what
+// crow::json::wvalue does; nlohmann::json stands in for it here since the bench does not link
+// Crow), nlohmann's own CBOR/MessagePack encoders over that DOM, and the stream writers the
+// list routes use (json_stream.h, binary_stream.h). Reports time per row and body size.
+//
+//   g++ -O2 -std=c++17 -I.. format_bench.cpp -o format_bench
+//   ./format_bench [rows] [rounds]      (defaults: 100000 20)
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "binary_stream.h"
+#include "json_stream.h"
+
+using json = nlohmann::json;
+
+struct BillRow {
+    long long id, patientId, appointmentId;
+    double medicationFee, consultationFee, surgeryFee, totalFee;
+    long long isInsured, claimed;
+    std::string insuranceCompany, claimStatus;
+};
+
+std::vector<BillRow> makeRows(size_t count) {
+    static const char* statuses[] = {"Pending", "Approved", "Rejected", "None"};
+    std::vector<BillRow> rows;
+    rows.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        long long id = static_cast<long long>(i + 1);
+        double medication = static_cast<double>((i * 7919) % 50000) / 100;
+        double consultation = static_cast<double>(5000 + (i * 104729) % 20000) / 100;
+        double surgery = i % 5 ? 0.0 : static_cast<double>((i * 1299709) % 900000) / 100;
+        rows.push_back({id, id % 20000 + 1, id, medication, consultation, surgery, medication + consultation + surgery,
+                        static_cast<long long>(i % 2), static_cast<long long>(i % 4 == 0),
+                        i % 2 ? "Insurer " + std::to_string(i % 20) : "", statuses[i % 4]});
+    }
+    return rows;
+}
+
+json domPage(const std::vector<BillRow>& rows) {
+    json bills = json::array();
+    for (const BillRow& row : rows) {
+        json bill;
+        bill["id"] = row.id;
+        bill["patientId"] = row.patientId;
+        bill["appointmentId"] = row.appointmentId;
+        bill["medicationFee"] = row.medicationFee;
+        bill["consultationFee"] = row.consultationFee;
+        bill["surgeryFee"] = row.surgeryFee;
+        bill["totalFee"] = row.totalFee;
+        bill["isInsured"] = row.isInsured;
+        bill["claimed"] = row.claimed;
+        bill["insuranceCompany"] = row.insuranceCompany;
+        bill["claimStatus"] = row.claimStatus;
+        bills.push_back(std::move(bill));
+    }
+    json page;
+    page["bills"] = std::move(bills);
+    page["nextCursor"] = nullptr;
+    return page;
+}
+
+// Same shape as listPage() in list_query.h
+template <typename Writer>
+std::string streamPage(const std::vector<BillRow>& rows) {
+    std::string body;
+    StringSink sink(body);
+    Writer writer(sink);
+    writer.beginObject();
+    writer.key("bills");
+    writer.beginArray();
+    for (const BillRow& row : rows) {
+        writer.beginObject();
+        writer.key("id");
+        writer.value(row.id);
+        writer.key("patientId");
+        writer.value(row.patientId);
+        writer.key("appointmentId");
+        writer.value(row.appointmentId);
+        writer.key("medicationFee");
+        writer.value(row.medicationFee);
+        writer.key("consultationFee");
+        writer.value(row.consultationFee);
+        writer.key("surgeryFee");
+        writer.value(row.surgeryFee);
+        writer.key("totalFee");
+        writer.value(row.totalFee);
+        writer.key("isInsured");
+        writer.value(row.isInsured);
+        writer.key("claimed");
+        writer.value(row.claimed);
+        writer.key("insuranceCompany");
+        writer.value(row.insuranceCompany);
+        writer.key("claimStatus");
+        writer.value(row.claimStatus);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.key("nextCursor");
+    writer.null();
+    writer.endObject();
+    writer.finish();
+    return body;
+}
+
+// Best of `rounds` runs of fn(), which returns the body; the last body is kept in `body`
+template <typename Fn>
+double bestSeconds(int rounds, std::string& body, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < rounds; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body = fn();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+    std::vector<BillRow> rows = makeRows(count);
+
+    struct Result {
+        const char* name;
+        double seconds;
+        std::string body;
+    };
+    std::vector<Result> results;
+    auto run = [&](const char* name, auto fn) {
+        Result result{name, 0, {}};
+        result.seconds = bestSeconds(rounds, result.body, fn);
+        results.push_back(std::move(result));
+    };
+
+    run("DOM -> JSON (wvalue-style)", [&] { return domPage(rows).dump(); });
+    run("DOM -> CBOR (nlohmann)", [&] {
+        std::vector<uint8_t> bytes = json::to_cbor(domPage(rows));
+        return std::string(bytes.begin(), bytes.end());
+    });
+    run("DOM -> MessagePack (nlohmann)", [&] {
+        std::vector<uint8_t> bytes = json::to_msgpack(domPage(rows));
+        return std::string(bytes.begin(), bytes.end());
+    });
+    run("stream JSON", [&] { return streamPage<JsonStreamWriter>(rows); });
+    run("stream CBOR", [&] { return streamPage<CborStreamWriter>(rows); });
+    run("stream MessagePack", [&] { return streamPage<MsgPackStreamWriter>(rows); });
+
+    // Every encoding has to decode to the same document
+    json expected = json::parse(results[0].body);
+    bool same = json::parse(results[3].body) == expected &&
+                json::from_cbor(results[1].body) == expected && json::from_cbor(results[4].body) == expected &&
+                json::from_msgpack(results[2].body) == expected && json::from_msgpack(results[5].body) == expected;
+
+    double baseline = results[0].seconds;
+    size_t baselineBytes = results[0].body.size();
+    std::cout << count << " bill rows, best of " << rounds << std::endl;
+    for (const Result& result : results) {
+        std::cout << std::left << std::setw(32) << result.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << result.seconds * 1e9 / static_cast<double>(count) << " ns/row "
+                  << std::setw(6) << std::setprecision(2) << baseline / result.seconds << "x "
+                  << std::setw(8) << result.body.size() / static_cast<double>(count) << " bytes/row "
+                  << std::setw(6) << static_cast<double>(result.body.size()) / baselineBytes << " of JSON" << std::endl;
+    }
+    if (!same) {
+        std::cout << "Encodings decode to different documents" << std::endl;
+    }
+    return same ? 0 : 1;
+}
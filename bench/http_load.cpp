@@ -0,0 +1,640 @@
+// HTTP load generator for the API. Drives each route in turn with a fixed number of
+// keep-alive connections (one thread each, closed loop) and reports throughput and latency
+// quantiles per route. Request parameters are drawn from the id ranges found in the
+// database the server runs on, typically one created by seed_data.
+//
+//   cmake --build build --target http_load
+//   ./build/http_load --db bench.db [--port 8080] [--threads 8] [--duration 10] [--routes bills,patients]
+//                     [--csv results.csv] [--baseline previous.csv] [--tolerance 0.2]
+//
+// With --baseline, a route whose p99 rose or whose throughput fell by more than the tolerance
+// is reported as a regression and the exit status is 2. The WebSocket notification stream is
+// not driven; everything else in main.cpp is.
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sqlite3.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "latency_histogram.h"
+
+namespace {
+
+// Id ranges of the target database
+struct Dataset {
+    long long patients = 0;
+    long long doctors = 0;
+    long long bills = 0;
+    long long prescriptions = 0;
+    std::vector<std::string> items;
+};
+
+long long maxId(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    long long value = 0;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+Dataset loadDataset(const std::string& path) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::string error = sqlite3_errmsg(db);
+        sqlite3_close(db);
+        throw std::runtime_error("Cannot open " + path + ": " + error);
+    }
+    Dataset data;
+    data.patients = maxId(db, "SELECT COALESCE(MAX(id), 0) FROM Patients");
+    data.doctors = maxId(db, "SELECT COALESCE(MAX(id), 0) FROM Doctors");
+    data.bills = maxId(db, "SELECT COALESCE(MAX(id), 0) FROM Bills");
+    data.prescriptions = maxId(db, "SELECT COALESCE(MAX(prescriptionId), 0) FROM Prescriptions");
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT itemName FROM Inventory ORDER BY id", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            data.items.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    if (data.patients == 0 || data.doctors == 0 || data.bills == 0 || data.items.empty()) {
+        throw std::runtime_error(path + " has no data to drive the routes with; run seed_data first");
+    }
+    return data;
+}
+
+// ------------------ Requests ------------------
+
+struct Request {
+    const char* method = "GET";
+    std::string target;
+    std::string body;
+};
+
+using Rng = std::mt19937_64;
+
+long long randomId(Rng& rng, long long max) {
+    return max > 0 ? static_cast<long long>(rng() % static_cast<unsigned long long>(max)) + 1 : 1;
+}
+
+std::string randomDate(Rng& rng) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "20%02d-%02d-%02d", 24 + static_cast<int>(rng() % 6),
+                  1 + static_cast<int>(rng() % 12), 1 + static_cast<int>(rng() % 28));
+    return buffer;
+}
+
+std::string randomTime(Rng& rng) {
+    int slot = static_cast<int>(rng() % 49);
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%02d:%02d", 9 + slot / 6, slot % 6 * 10);
+    return buffer;
+}
+
+std::string urlEncode(const std::string& text) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : text) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 15];
+        }
+    }
+    return out;
+}
+
+struct Scenario {
+    const char* name;
+    std::function<Request(Rng&, const Dataset&)> make;
+};
+
+// One scenario per route in main.cpp, with parameters that hit existing rows
+std::vector<Scenario> scenarios() {
+    auto get = [](std::string target) {
+        Request request;
+        request.target = std::move(target);
+        return request;
+    };
+    auto post = [](std::string target, std::string body) {
+        Request request;
+        request.method = "POST";
+        request.target = std::move(target);
+        request.body = std::move(body);
+        return request;
+    };
+    return {
+        {"home", [=](Rng&, const Dataset&) { return get("/"); }},
+        {"patients", [=](Rng& rng, const Dataset& d) {
+             return get("/patients?limit=100&after_id=" + std::to_string(randomId(rng, d.patients) - 1));
+         }},
+        {"doctors", [=](Rng& rng, const Dataset& d) {
+             return get("/doctors?limit=100&after_id=" + std::to_string(randomId(rng, d.doctors) - 1));
+         }},
+        {"appointments", [=](Rng& rng, const Dataset& d) {
+             return get("/appointments?doctorId=" + std::to_string(randomId(rng, d.doctors)) + "&limit=50");
+         }},
+        {"bills", [=](Rng& rng, const Dataset& d) {
+             return get("/bills?patientId=" + std::to_string(randomId(rng, d.patients)) + "&limit=50");
+         }},
+        {"bills_by_status", [=](Rng& rng, const Dataset& d) {
+             return get("/bills?claimStatus=Pending&limit=200&after_id=" + std::to_string(randomId(rng, d.bills) - 1));
+         }},
+        {"inventory", [=](Rng&, const Dataset&) { return get("/inventory?limit=100"); }},
+        {"availability", [=](Rng& rng, const Dataset& d) {
+             return get("/availability?doctorId=" + std::to_string(randomId(rng, d.doctors)) + "&date=" + randomDate(rng));
+         }},
+        {"notifications", [=](Rng&, const Dataset&) { return get("/notifications?limit=100"); }},
+        {"export_doctors", [=](Rng&, const Dataset&) { return get("/export/doctors"); }},
+        {"export_inventory", [=](Rng&, const Dataset&) { return get("/export/inventory"); }},
+        {"cache_stats", [=](Rng&, const Dataset&) { return get("/cache_stats"); }},
+        {"metrics", [=](Rng&, const Dataset&) { return get("/metrics"); }},
+        {"register", [=](Rng& rng, const Dataset&) {
+             return get("/register?name=Load%20Patient&address=" + std::to_string(rng() % 9000) +
+                        "%20Main%20Street&medicalHistory=None&insuranceCompany=Acme%20Health");
+         }},
+        {"register_doctor", [=](Rng& rng, const Dataset&) {
+             return get("/register_doctor?name=Dr%20Load&specialty=General&contactInfo=555-" + std::to_string(rng() % 10000));
+         }},
+        {"book_appointment", [=](Rng& rng, const Dataset& d) {
+             return get("/book_appointment?patientId=" + std::to_string(randomId(rng, d.patients)) +
+                        "&doctorId=" + std::to_string(randomId(rng, d.doctors)) + "&date=" + randomDate(rng) +
+                        "&time=" + randomTime(rng));
+         }},
+        {"add_prescription", [=](Rng& rng, const Dataset& d) {
+             return get("/add_prescription?patientId=" + std::to_string(randomId(rng, d.patients)) +
+                        "&doctorId=" + std::to_string(randomId(rng, d.doctors)) + "&medication=" +
+                        urlEncode(d.items[rng() % d.items.size()]) +
+                        "&dosage=500mg&instructions=Once%20daily&datePrescribed=" + randomDate(rng));
+         }},
+        {"update_bill", [=](Rng& rng, const Dataset& d) {
+             return get("/update_bill?billId=" + std::to_string(randomId(rng, d.bills)) +
+                        "&medicationFee=12.5&consultationFee=80&surgeryFee=0");
+         }},
+        {"ask_for_billing", [=](Rng& rng, const Dataset& d) {
+             return get("/ask_for_billing?billId=" + std::to_string(randomId(rng, d.bills)));
+         }},
+        {"approve_insurance", [=](Rng& rng, const Dataset& d) {
+             return get("/approve_insurance?billId=" + std::to_string(randomId(rng, d.bills)));
+         }},
+        {"update_inventory_item", [=](Rng& rng, const Dataset& d) {
+             return get("/update_inventory_item?itemName=" + urlEncode(d.items[rng() % d.items.size()]) + "&delta=5");
+         }},
+        {"dispense_prescription", [=](Rng& rng, const Dataset& d) {
+             return get("/dispense_prescription?prescriptionId=" + std::to_string(randomId(rng, d.prescriptions)) +
+                        "&quantity=1");
+         }},
+        {"register_batch", [=](Rng& rng, const Dataset&) {
+             std::string body = "[";
+             for (int i = 0; i < 50; ++i) {
+                 body += i ? "," : "";
+                 body += "{\"name\":\"Batch Patient\",\"address\":\"" + std::to_string(rng() % 9000) +
+                         " Main Street\",\"medicalHistory\":\"None\"}";
+             }
+             return post("/register/batch", body + "]");
+         }},
+        {"book_appointment_batch", [=](Rng& rng, const Dataset& d) {
+             std::string body = "[";
+             for (int i = 0; i < 50; ++i) {
+                 body += i ? "," : "";
+                 body += "{\"patientId\":" + std::to_string(randomId(rng, d.patients)) +
+                         ",\"doctorId\":" + std::to_string(randomId(rng, d.doctors)) + ",\"date\":\"" +
+                         randomDate(rng) + "\",\"time\":\"" + randomTime(rng) + "\"}";
+             }
+             return post("/book_appointment/batch", body + "]");
+         }},
+        {"add_prescription_batch", [=](Rng& rng, const Dataset& d) {
+             std::string body = "[";
+             for (int i = 0; i < 50; ++i) {
+                 body += i ? "," : "";
+                 body += "{\"patientId\":" + std::to_string(randomId(rng, d.patients)) +
+                         ",\"doctorId\":" + std::to_string(randomId(rng, d.doctors)) +
+                         ",\"medication\":\"Amoxicillin\",\"dosage\":\"500mg\",\"instructions\":\"Once daily\"," +
+                         "\"datePrescribed\":\"" + randomDate(rng) + "\"}";
+             }
+             return post("/add_prescription/batch", body + "]");
+         }},
+    };
+}
+
+// ------------------ HTTP Client ------------------
+
+// Minimal HTTP/1.1 keep-alive client: Content-Length and chunked responses
+class Connection {
+public:
+    Connection(const addrinfo* address, std::string host) : address_(address), host_(std::move(host)) {}
+    ~Connection() { close(); }
+
+    // Sends `request` and reads the response; returns the status code, or -1 on a transport error
+    int roundTrip(const Request& request) {
+        std::string wire = std::string(request.method) + ' ' + request.target + " HTTP/1.1\r\nHost: " + host_ + "\r\n";
+        if (!request.body.empty()) {
+            wire += "Content-Type: application/json\r\nContent-Length: " + std::to_string(request.body.size()) + "\r\n";
+        }
+        wire += "\r\n";
+        wire += request.body;
+
+        // A keep-alive connection the server closed meanwhile gets one retry on a fresh socket
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            bool reused = fd_ >= 0;
+            if (!reused && !open()) {
+                return -1;
+            }
+            int status = -1;
+            if (sendAll(wire) && (status = readResponse()) > 0) {
+                return status;
+            }
+            close();
+            if (!reused) {
+                break;
+            }
+        }
+        return -1;
+    }
+
+private:
+    bool open() {
+        fd_ = ::socket(address_->ai_family, address_->ai_socktype, address_->ai_protocol);
+        if (fd_ < 0) {
+            return false;
+        }
+        int one = 1;
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (::connect(fd_, address_->ai_addr, address_->ai_addrlen) != 0) {
+            close();
+            return false;
+        }
+        buffer_.clear();
+        return true;
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    bool sendAll(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool fill() {
+        char chunk[16384];
+        ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    // Reads one line ending in CRLF from the buffer position `pos`
+    bool readLine(size_t& pos, std::string& line) {
+        size_t end;
+        while ((end = buffer_.find("\r\n", pos)) == std::string::npos) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        line.assign(buffer_, pos, end - pos);
+        pos = end + 2;
+        return true;
+    }
+
+    bool need(size_t bytes) {
+        while (buffer_.size() < bytes) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int readResponse() {
+        size_t pos = 0;
+        std::string line;
+        if (!readLine(pos, line) || line.compare(0, 5, "HTTP/") != 0 || line.size() < 12) {
+            return -1;
+        }
+        int status = std::atoi(line.c_str() + 9);
+        long long contentLength = -1;
+        bool chunked = false;
+        bool closeAfter = false;
+        while (readLine(pos, line) && !line.empty()) {
+            std::string lower = line;
+            for (char& c : lower) {
+                c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            }
+            if (lower.compare(0, 15, "content-length:") == 0) {
+                contentLength = std::atoll(line.c_str() + 15);
+            } else if (lower.compare(0, 18, "transfer-encoding:") == 0 && lower.find("chunked") != std::string::npos) {
+                chunked = true;
+            } else if (lower.compare(0, 11, "connection:") == 0 && lower.find("close") != std::string::npos) {
+                closeAfter = true;
+            }
+        }
+        if (!line.empty()) {
+            return -1;
+        }
+
+        if (chunked) {
+            while (true) {
+                if (!readLine(pos, line)) {
+                    return -1;
+                }
+                size_t size = std::strtoull(line.c_str(), nullptr, 16);
+                if (!need(pos + size + 2)) {
+                    return -1;
+                }
+                pos += size + 2;
+                if (size == 0) {
+                    break;
+                }
+            }
+        } else if (contentLength >= 0) {
+            if (!need(pos + static_cast<size_t>(contentLength))) {
+                return -1;
+            }
+            pos += static_cast<size_t>(contentLength);
+        } else {
+            // No length: the body runs until the server closes the connection
+            while (fill()) {
+            }
+            pos = buffer_.size();
+            closeAfter = true;
+        }
+        buffer_.erase(0, pos);
+        if (closeAfter) {
+            close();
+        }
+        return status;
+    }
+
+    const addrinfo* address_;
+    std::string host_;
+    int fd_ = -1;
+    std::string buffer_;
+};
+
+// ------------------ Load Runs ------------------
+
+struct RouteResult {
+    std::string route;
+    uint64_t requests = 0;
+    uint64_t ok = 0;           // 1xx-3xx
+    uint64_t clientErrors = 0; // 4xx, e.g. a slot that was already booked
+    uint64_t serverErrors = 0; // 5xx
+    uint64_t transportErrors = 0;
+    double throughput = 0;     // requests per second
+    double p50Ms = 0, p99Ms = 0, p999Ms = 0;
+};
+
+RouteResult runScenario(const Scenario& scenario, const Dataset& data, const addrinfo* address,
+                        const std::string& host, int threads, double duration) {
+    LatencyHistogram latency;
+    std::atomic<uint64_t> ok{0}, clientErrors{0}, serverErrors{0}, transportErrors{0};
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(duration));
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            Rng rng(0x9E3779B97F4A7C15ULL * static_cast<unsigned long long>(t + 1));
+            Connection connection(address, host);
+            while (std::chrono::steady_clock::now() < deadline) {
+                Request request = scenario.make(rng, data);
+                auto sent = std::chrono::steady_clock::now();
+                int status = connection.roundTrip(request);
+                auto elapsed = std::chrono::steady_clock::now() - sent;
+                if (status < 0) {
+                    transportErrors.fetch_add(1, std::memory_order_relaxed);
+                    // Do not spin on a refused connection
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    continue;
+                }
+                latency.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+                (status < 400 ? ok : status < 500 ? clientErrors : serverErrors).fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    RouteResult result;
+    result.route = scenario.name;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LatencyHistogram::Snapshot snap = latency.snapshot();
+    result.requests = snap.count;
+    result.throughput = static_cast<double>(snap.count) / seconds;
+    result.ok = ok;
+    result.clientErrors = clientErrors;
+    result.serverErrors = serverErrors;
+    result.transportErrors = transportErrors;
+    result.p50Ms = static_cast<double>(snap.quantile(0.5)) / 1000;
+    result.p99Ms = static_cast<double>(snap.quantile(0.99)) / 1000;
+    result.p999Ms = static_cast<double>(snap.quantile(0.999)) / 1000;
+    return result;
+}
+
+// ------------------ Reports ------------------
+
+const char* const kCsvHeader = "route,requests,throughput,p50_ms,p99_ms,p999_ms,ok,4xx,5xx,transport_errors";
+
+void writeCsv(const std::string& path, const std::vector<RouteResult>& results) {
+    std::ofstream out(path, std::ios::trunc);
+    out << kCsvHeader << '\n';
+    for (const RouteResult& r : results) {
+        out << r.route << ',' << r.requests << ',' << r.throughput << ',' << r.p50Ms << ',' << r.p99Ms << ','
+            << r.p999Ms << ',' << r.ok << ',' << r.clientErrors << ',' << r.serverErrors << ','
+            << r.transportErrors << '\n';
+    }
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+std::map<std::string, RouteResult> readCsv(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot read baseline " + path);
+    }
+    std::map<std::string, RouteResult> results;
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string field;
+        std::vector<std::string> values;
+        while (std::getline(fields, field, ',')) {
+            values.push_back(field);
+        }
+        if (values.size() < 6) {
+            continue;
+        }
+        RouteResult r;
+        r.route = values[0];
+        r.requests = std::strtoull(values[1].c_str(), nullptr, 10);
+        r.throughput = std::strtod(values[2].c_str(), nullptr);
+        r.p50Ms = std::strtod(values[3].c_str(), nullptr);
+        r.p99Ms = std::strtod(values[4].c_str(), nullptr);
+        r.p999Ms = std::strtod(values[5].c_str(), nullptr);
+        results[r.route] = r;
+    }
+    return results;
+}
+
+struct Options {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    std::string db = "bench.db";
+    int threads = 8;
+    double duration = 10;
+    std::vector<std::string> routes;
+    std::string csv;
+    std::string baseline;
+    double tolerance = 0.2;
+};
+
+Options parseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            throw std::runtime_error("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+        if (arg == "--host") {
+            options.host = value;
+        } else if (arg == "--port") {
+            options.port = value;
+        } else if (arg == "--db") {
+            options.db = value;
+        } else if (arg == "--threads") {
+            options.threads = std::atoi(value.c_str());
+        } else if (arg == "--duration") {
+            options.duration = std::strtod(value.c_str(), nullptr);
+        } else if (arg == "--routes") {
+            std::istringstream names(value);
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                options.routes.push_back(name);
+            }
+        } else if (arg == "--csv") {
+            options.csv = value;
+        } else if (arg == "--baseline") {
+            options.baseline = value;
+        } else if (arg == "--tolerance") {
+            options.tolerance = std::strtod(value.c_str(), nullptr);
+        } else {
+            throw std::runtime_error("Unknown option " + arg);
+        }
+    }
+    if (options.threads < 1 || !(options.duration > 0) || !(options.tolerance >= 0)) {
+        throw std::runtime_error("--threads, --duration and --tolerance must be positive");
+    }
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        Options options = parseOptions(argc, argv);
+        Dataset data = loadDataset(options.db);
+
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* address = nullptr;
+        if (int rc = ::getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &address)) {
+            throw std::runtime_error("Cannot resolve " + options.host + ": " + gai_strerror(rc));
+        }
+        std::string host = options.host + ":" + options.port;
+
+        std::vector<RouteResult> results;
+        std::printf("%-24s %10s %10s %8s %8s %8s %7s %7s %7s\n", "route", "requests", "req/s", "p50 ms",
+                    "p99 ms", "p999 ms", "4xx", "5xx", "errors");
+        for (const Scenario& scenario : scenarios()) {
+            if (!options.routes.empty() &&
+                std::find(options.routes.begin(), options.routes.end(), scenario.name) == options.routes.end()) {
+                continue;
+            }
+            RouteResult r = runScenario(scenario, data, address, host, options.threads, options.duration);
+            std::printf("%-24s %10llu %10.1f %8.3f %8.3f %8.3f %7llu %7llu %7llu\n", r.route.c_str(),
+                        static_cast<unsigned long long>(r.requests), r.throughput, r.p50Ms, r.p99Ms, r.p999Ms,
+                        static_cast<unsigned long long>(r.clientErrors),
+                        static_cast<unsigned long long>(r.serverErrors),
+                        static_cast<unsigned long long>(r.transportErrors));
+            std::fflush(stdout);
+            results.push_back(r);
+        }
+        ::freeaddrinfo(address);
+
+        if (!options.csv.empty()) {
+            writeCsv(options.csv, results);
+        }
+
+        int status = 0;
+        for (const RouteResult& r : results) {
+            if (r.serverErrors > 0 || r.transportErrors > 0) {
+                status = 1;
+            }
+        }
+        if (!options.baseline.empty()) {
+            std::map<std::string, RouteResult> baseline = readCsv(options.baseline);
+            for (const RouteResult& r : results) {
+                auto it = baseline.find(r.route);
+                if (it == baseline.end()) {
+                    continue;
+                }
+                const RouteResult& base = it->second;
+                bool slower = base.p99Ms > 0 && r.p99Ms > base.p99Ms * (1 + options.tolerance);
+                bool fewer = r.throughput < base.throughput * (1 - options.tolerance);
+                if (slower || fewer) {
+                    std::printf("REGRESSION %-24s p99 %.3f -> %.3f ms, throughput %.1f -> %.1f req/s\n",
+                                r.route.c_str(), base.p99Ms, r.p99Ms, base.throughput, r.throughput);
+                    status = 2;
+                }
+            }
+        }
+        return status;
+    } catch (const std::exception& e) {
+        std::cerr << "http_load: " << e.what() << std::endl;
+        return 1;
+    }
+}
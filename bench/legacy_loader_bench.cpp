@@ -0,0 +1,128 @@
+// Benchmark: loading the legacy JSON data files. Compares the original approach (parse each
+// file into a nlohmann DOM, then copy every record out, one file after another) with
+// legacy_loader.h (mmap + SAX straight into the structs, six files in parallel).
+//
+//   g++ -O2 -std=c++17 -I.. legacy_loader_bench.cpp -pthread -o legacy_loader_bench
+//   ./legacy_loader_bench [dir] [patients]      (defaults: /tmp/legacy_bench 1000000)
+//
+// The dataset is generated into `dir` on first run, pretty-printed like the old saveToFile().
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "legacy_loader.h"
+
+using json = nlohmann::json;
+
+// Writes records as a pretty-printed JSON array without holding a DOM of the whole file
+template <typename T, typename Make>
+void writeDataFile(const std::string& path, size_t count, Make make) {
+    std::ofstream out(path, std::ios::trunc);
+    out << "[\n";
+    for (size_t i = 0; i < count; ++i) {
+        std::string record = json(make(i)).dump(4);
+        out << "    ";
+        for (char c : record) {
+            out << c;
+            if (c == '\n') {
+                out << "    ";
+            }
+        }
+        out << (i + 1 < count ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+void generate(const std::string& dir, size_t patients) {
+    std::filesystem::create_directories(dir);
+    std::cout << "Generating dataset with " << patients << " patients in " << dir << std::endl;
+    writeDataFile<Patient>(dir + "/patients.json", patients, [](size_t i) {
+        int id = static_cast<int>(i + 1);
+        return Patient{id, "Patient " + std::to_string(id), std::to_string(i % 9000) + " Main Street",
+                       i % 3 ? "None" : "Hypertension, seasonal allergies", i % 2 == 0,
+                       i % 2 == 0 ? "Insurer " + std::to_string(i % 20) : ""};
+    });
+    writeDataFile<Doctor>(dir + "/doctors.json", patients / 1000 + 1, [](size_t i) {
+        int id = static_cast<int>(i + 1);
+        return Doctor{id, "Dr " + std::to_string(id), i % 2 ? "Surgery" : "General", "555-" + std::to_string(1000 + i)};
+    });
+    writeDataFile<Appointment>(dir + "/appointments.json", patients / 2, [patients](size_t i) {
+        return Appointment{static_cast<int>(i % patients + 1), static_cast<int>(i % (patients / 1000 + 1) + 1),
+                           "2025-0" + std::to_string(i % 9 + 1) + "-1" + std::to_string(i % 10), "09:00"};
+    });
+    writeDataFile<MedicalRecord>(dir + "/medical_records.json", patients / 4, [patients](size_t i) {
+        return MedicalRecord{static_cast<int>(i + 1), static_cast<int>(i % patients + 1), "2025-01-02",
+                             "Routine checkup, follow up in six months", "Healthy"};
+    });
+    writeDataFile<Prescription>(dir + "/prescriptions.json", patients / 4, [patients](size_t i) {
+        return Prescription{static_cast<int>(i + 1), static_cast<int>(i % patients + 1), 1, "Amoxicillin",
+                            "500mg", "Twice daily after meals", "2025-01-02"};
+    });
+    writeDataFile<Bill>(dir + "/bills.json", patients / 2, [patients](size_t i) {
+        return Bill{static_cast<int>(i + 1), static_cast<int>(i % patients + 1), static_cast<int>(i + 1),
+                    10.5, 20.0, 0.0, 30.5, i % 2 == 0, false, i % 2 == 0 ? "Insurer 1" : "", "None"};
+    });
+}
+
+// The original loaders: whole-file DOM, then a copy of every record
+template <typename T>
+std::vector<T> domLoad(const std::string& path) {
+    std::vector<T> records;
+    std::ifstream file(path);
+    json arr;
+    file >> arr;
+    for (auto& item : arr) {
+        try {
+            records.push_back(item.get<T>());
+        } catch (const json::exception&) {
+            continue;
+        }
+    }
+    return records;
+}
+
+size_t total(const LegacyData& d) {
+    return d.patients.size() + d.doctors.size() + d.appointments.size() + d.medicalRecords.size() +
+           d.prescriptions.size() + d.bills.size();
+}
+
+template <typename Fn>
+double seconds(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "/tmp/legacy_bench";
+    size_t patients = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    if (!std::filesystem::exists(dir + "/patients.json")) {
+        generate(dir, patients);
+    }
+
+    LegacyData dom;
+    double domSeconds = seconds([&] {
+        dom.patients = domLoad<Patient>(dir + "/patients.json");
+        dom.doctors = domLoad<Doctor>(dir + "/doctors.json");
+        dom.appointments = domLoad<Appointment>(dir + "/appointments.json");
+        dom.medicalRecords = domLoad<MedicalRecord>(dir + "/medical_records.json");
+        dom.prescriptions = domLoad<Prescription>(dir + "/prescriptions.json");
+        dom.bills = domLoad<Bill>(dir + "/bills.json");
+    });
+    size_t domRecords = total(dom);
+    dom = LegacyData();
+
+    LegacyData sax;
+    double saxSeconds = seconds([&] { sax = loadLegacyData(dir); });
+
+    std::cout << "DOM, sequential:  " << domRecords << " records in " << domSeconds << " s" << std::endl;
+    std::cout << "SAX, parallel:    " << total(sax) << " records in " << saxSeconds << " s ("
+              << domSeconds / saxSeconds << "x, " << std::thread::hardware_concurrency() << " hardware threads)"
+              << std::endl;
+    return total(sax) == domRecords ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+// Synthetic dataset for load tests: creates a database with the app's schema and migrations,
+// then inserts patients, doctors, appointments, bills, prescriptions and inventory
+// at realistic ratios. Generation is deterministic for a given --seed.
+//
+//   cmake --build build --target seed_data
+//   ./build/seed_data --db bench.db [--scale 1.0] [--seed 42]
+//
+// Volumes at --scale 1: 100k patients, 1k doctors, 500k appointments (one bill each),
+// 200k prescriptions and the inventory for every prescribed medication.
+
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "database.h"
+#include "validation.h"
+
+namespace {
+
+const char* const kSpecialties[] = {"General", "Cardiology", "Pediatrics", "Orthopedics", "Dermatology",
+                                    "Neurology", "Oncology", "Surgery", "Psychiatry", "Radiology"};
+const char* const kInsurers[] = {"Acme Health", "BlueCross", "CarePlus", "MediShield", "Unity Insurance"};
+const char* const kHistories[] = {"None", "Hypertension", "Type 2 diabetes", "Asthma", "Seasonal allergies",
+                                  "Hypertension, high cholesterol", "Migraine", "Arthritis"};
+const char* const kMedications[] = {"Amoxicillin", "Atorvastatin", "Lisinopril", "Metformin", "Amlodipine",
+                                    "Omeprazole", "Levothyroxine", "Albuterol", "Ibuprofen", "Paracetamol",
+                                    "Sertraline", "Prednisone", "Azithromycin", "Losartan", "Gabapentin",
+                                    "Hydrochlorothiazide", "Cetirizine", "Insulin glargine", "Warfarin",
+                                    "Clopidogrel"};
+const char* const kSupplies[] = {"Syringe 5ml", "Gauze pad", "Nitrile gloves", "Saline 500ml", "Bandage roll",
+                                 "Face mask", "Alcohol swab", "IV cannula"};
+const char* const kClaimStatuses[] = {"Not Submitted", "Not Submitted", "Not Submitted", "Pending", "Pending",
+                                      "Approved", "Not Submitted", "Rejected"};
+
+constexpr int kSlotsPerDay = 49;  // 09:00 to 17:00 every 10 minutes
+constexpr int kDays = 730;        // two years of bookings from 2024-01-01
+
+template <size_t N>
+const char* pick(std::mt19937_64& rng, const char* const (&values)[N]) {
+    return values[rng() % N];
+}
+
+void exec(sqlite3* db, const char* sql) {
+    char* error = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &error) != SQLITE_OK) {
+        std::string message = error ? error : "unknown error";
+        sqlite3_free(error);
+        throw std::runtime_error(std::string(sql) + ": " + message);
+    }
+}
+
+// Owns one prepared statement; run() binds nothing itself, callers bind then run
+class Statement {
+public:
+    Statement(sqlite3* db, const char* sql) : db_(db) {
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt_, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Failed to prepare ") + sql + ": " + sqlite3_errmsg(db));
+        }
+    }
+    ~Statement() { sqlite3_finalize(stmt_); }
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+
+    operator sqlite3_stmt*() const { return stmt_; }
+
+    void text(int index, const std::string& value) {
+        sqlite3_bind_text(stmt_, index, value.c_str(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+    }
+
+    void run() {
+        if (sqlite3_step(stmt_) != SQLITE_DONE) {
+            throw std::runtime_error(std::string("Insert failed: ") + sqlite3_errmsg(db_));
+        }
+        sqlite3_reset(stmt_);
+    }
+
+private:
+    sqlite3* db_;
+    sqlite3_stmt* stmt_ = nullptr;
+};
+
+long long maxId(sqlite3* db, const char* table, const char* column) {
+    std::string sql = std::string("SELECT COALESCE(MAX(") + column + "), 0) FROM " + table;
+    Statement stmt(db, sql.c_str());
+    return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
+}
+
+// Civil date for a day offset from 2024-01-01
+std::string dateForDay(int day) {
+    int year = 2024, month = 1, dayOfMonth = 1 + day;
+    while (true) {
+        int length = daysInMonth(year, month);
+        if (dayOfMonth <= length) {
+            break;
+        }
+        dayOfMonth -= length;
+        if (++month > 12) {
+            month = 1;
+            ++year;
+        }
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", year, month, dayOfMonth);
+    return buffer;
+}
+
+std::string timeForSlotIndex(int slot) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%02d:%02d", 9 + slot / 6, slot % 6 * 10);
+    return buffer;
+}
+
+struct Options {
+    std::string db = "bench.db";
+    std::string schema = "database.sql";
+    std::string migrations = "migrations";
+    double scale = 1.0;
+    unsigned long long seed = 42;
+};
+
+Options parseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            throw std::runtime_error("Missing value for " + arg);
+        }
+        if (arg == "--db") {
+            options.db = value;
+        } else if (arg == "--schema") {
+            options.schema = value;
+        } else if (arg == "--migrations") {
+            options.migrations = value;
+        } else if (arg == "--scale") {
+            options.scale = std::strtod(value, nullptr);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(value, nullptr, 10);
+        } else {
+            throw std::runtime_error("Unknown option " + arg);
+        }
+        ++i;
+    }
+    if (!(options.scale > 0)) {
+        throw std::runtime_error("--scale must be positive");
+    }
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        Options options = parseOptions(argc, argv);
+        auto count = [&](double base) { return static_cast<long long>(base * options.scale + 0.5); };
+        const long long patients = std::max(count(100000), 1LL);
+        const long long doctors = std::max(count(1000), 1LL);
+        const long long appointments = std::min(count(500000), doctors * kDays * kSlotsPerDay);
+        const long long prescriptions = count(200000);
+
+        sqlite3* db = initDatabase(options.db, options.schema);
+        applyMigrations(db, options.migrations);
+        // Bulk load: durability does not matter until the final commit
+        exec(db, "PRAGMA synchronous=OFF");
+        exec(db, "BEGIN");
+        auto start = std::chrono::steady_clock::now();
+        std::mt19937_64 rng(options.seed);
+
+        if (maxId(db, "Patients", "id") > 0 || maxId(db, "Appointments", "id") > 0) {
+            throw std::runtime_error(options.db + " already has data; seed into a fresh database");
+        }
+
+        std::vector<const char*> patientInsurer(static_cast<size_t>(patients));
+        {
+            Statement insert(db, "INSERT INTO Patients (id, name, address, medicalHistory, hasInsurance, insuranceCompany) "
+                                 "VALUES (?, ?, ?, ?, ?, ?)");
+            for (long long i = 0; i < patients; ++i) {
+                long long id = i + 1;
+                bool insured = rng() % 10 < 7;
+                patientInsurer[static_cast<size_t>(i)] = insured ? pick(rng, kInsurers) : nullptr;
+                sqlite3_bind_int64(insert, 1, id);
+                insert.text(2, "Patient " + std::to_string(id));
+                insert.text(3, std::to_string(rng() % 9000 + 1) + " Main Street");
+                sqlite3_bind_text(insert, 4, pick(rng, kHistories), -1, SQLITE_STATIC);
+                sqlite3_bind_int(insert, 5, insured ? 1 : 0);
+                sqlite3_bind_text(insert, 6, insured ? patientInsurer[static_cast<size_t>(i)] : "", -1, SQLITE_STATIC);
+                insert.run();
+            }
+        }
+
+        {
+            Statement insert(db, "INSERT INTO Doctors (id, name, specialty, contactInfo) VALUES (?, ?, ?, ?)");
+            for (long long i = 0; i < doctors; ++i) {
+                long long id = i + 1;
+                sqlite3_bind_int64(insert, 1, id);
+                insert.text(2, "Dr. " + std::to_string(id));
+                sqlite3_bind_text(insert, 3, pick(rng, kSpecialties), -1, SQLITE_STATIC);
+                insert.text(4, "555-" + std::to_string(1000000 + id));
+                insert.run();
+            }
+        }
+
+        {
+            Statement appointment(db, "INSERT INTO Appointments (patientId, doctorId, date, time) VALUES (?, ?, ?, ?)");
+            Statement bill(db, "INSERT INTO Bills (patientId, appointmentId, medicationFee, consultationFee, surgeryFee, "
+                               "totalFee, isInsured, claimed, insuranceCompany, claimStatus) "
+                               "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+            // Each doctor's n-th appointment takes slot n * stride of the two-year calendar; the
+            // stride is coprime with the slot count, so slots never repeat and spread over all days
+            const long long slotCount = static_cast<long long>(kDays) * kSlotsPerDay;
+            const long long stride = 7919;
+            for (long long i = 0; i < appointments; ++i) {
+                long long patientIndex = static_cast<long long>(rng() % static_cast<unsigned long long>(patients));
+                long long slot = (i / doctors * stride + i % doctors) % slotCount;
+                sqlite3_bind_int64(appointment, 1, patientIndex + 1);
+                sqlite3_bind_int64(appointment, 2, i % doctors + 1);
+                appointment.text(3, dateForDay(static_cast<int>(slot / kSlotsPerDay)));
+                appointment.text(4, timeForSlotIndex(static_cast<int>(slot % kSlotsPerDay)));
+                appointment.run();
+                long long appointmentId = sqlite3_last_insert_rowid(db);
+
+                const char* insurer = patientInsurer[static_cast<size_t>(patientIndex)];
+                double medicationFee = static_cast<double>(rng() % 20000) / 100;
+                double consultationFee = 50 + static_cast<double>(rng() % 15000) / 100;
+                double surgeryFee = rng() % 20 == 0 ? static_cast<double>(rng() % 500000) / 100 : 0.0;
+                const char* status = insurer ? pick(rng, kClaimStatuses) : "Not Submitted";
+                sqlite3_bind_int64(bill, 1, patientIndex + 1);
+                sqlite3_bind_int64(bill, 2, appointmentId);
+                sqlite3_bind_double(bill, 3, medicationFee);
+                sqlite3_bind_double(bill, 4, consultationFee);
+                sqlite3_bind_double(bill, 5, surgeryFee);
+                sqlite3_bind_double(bill, 6, medicationFee + consultationFee + surgeryFee);
+                sqlite3_bind_int(bill, 7, insurer ? 1 : 0);
+                sqlite3_bind_int(bill, 8, std::string(status) == "Not Submitted" ? 0 : 1);
+                sqlite3_bind_text(bill, 9, insurer ? insurer : "", -1, SQLITE_STATIC);
+                sqlite3_bind_text(bill, 10, status, -1, SQLITE_STATIC);
+                bill.run();
+            }
+        }
+
+        {
+            Statement insert(db, "INSERT INTO Prescriptions (patientId, doctorId, medication, dosage, instructions, datePrescribed) "
+                                 "VALUES (?, ?, ?, ?, ?, ?)");
+            for (long long i = 0; i < prescriptions; ++i) {
+                sqlite3_bind_int64(insert, 1, static_cast<long long>(rng() % static_cast<unsigned long long>(patients)) + 1);
+                sqlite3_bind_int64(insert, 2, static_cast<long long>(rng() % static_cast<unsigned long long>(doctors)) + 1);
+                sqlite3_bind_text(insert, 3, pick(rng, kMedications), -1, SQLITE_STATIC);
+                insert.text(4, std::to_string((rng() % 4 + 1) * 250) + "mg");
+                sqlite3_bind_text(insert, 5, rng() % 2 ? "Twice daily after meals" : "Once daily", -1, SQLITE_STATIC);
+                insert.text(6, dateForDay(static_cast<int>(rng() % kDays)));
+                insert.run();
+            }
+        }
+
+        {
+            // Stock for every medication (so prescriptions can be dispensed) and common supplies
+            Statement insert(db, "INSERT INTO Inventory (itemName, quantity) VALUES (?, ?)");
+            for (const char* item : kMedications) {
+                sqlite3_bind_text(insert, 1, item, -1, SQLITE_STATIC);
+                sqlite3_bind_int64(insert, 2, count(1000000));
+                insert.run();
+            }
+            for (const char* item : kSupplies) {
+                sqlite3_bind_text(insert, 1, item, -1, SQLITE_STATIC);
+                sqlite3_bind_int64(insert, 2, count(100000));
+                insert.run();
+            }
+        }
+
+        exec(db, "COMMIT");
+        exec(db, "ANALYZE");
+        sqlite3_close(db);
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Seeded " << options.db << " in " << seconds << " s: " << patients << " patients, " << doctors
+                  << " doctors, " << appointments << " appointments and bills, " << prescriptions
+                  << " prescriptions" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "seed_data: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,79 @@
+// Microbenchmark: request field validation, std::regex + istringstream + atoi (the old
+// implementation, kept here as the baseline) against the parsers in validation.h.
+//
+//   g++ -O2 -std=c++17 -I.. validation_bench.cpp -o validation_bench && ./validation_bench
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "validation.h"
+
+namespace legacy {
+
+bool isValidAppointmentTime(const std::string& time) {
+    std::regex timeRegex(R"(^([0-1][0-9]|2[0-3]):([0-5][0-9])$)");
+    if (!std::regex_match(time, timeRegex)) {
+        return false;
+    }
+    int hour, minute;
+    char colon;
+    std::istringstream(time) >> hour >> colon >> minute;
+    if (hour < 9 || hour > 17 || (hour == 17 && minute > 0)) {
+        return false;
+    }
+    return minute % 10 == 0;
+}
+
+bool isValidDate(const std::string& date) {
+    std::regex dateRegex(R"(^\d{4}-\d{2}-\d{2}$)");
+    return std::regex_match(date, dateRegex);
+}
+
+} // namespace legacy
+
+template <typename Fn>
+double nsPerCall(size_t iterations, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(iterations);
+}
+
+void report(const char* name, double legacyNs, double currentNs) {
+    std::cout << name << ": legacy " << legacyNs << " ns/call, validation.h " << currentNs
+              << " ns/call (" << legacyNs / currentNs << "x)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+    const std::vector<std::string> dates = {"2025-01-02", "2024-02-29", "2025-02-30", "2025-1-02", "abcd-ef-gh"};
+    const std::vector<std::string> times = {"09:00", "12:30", "17:00", "17:10", "08:59", "9:00"};
+    const std::vector<std::string> numbers = {"1", "42", "123456", "-7", "12x"};
+
+    // Accumulated so the compiler cannot drop the calls
+    volatile long long sink = 0;
+
+    double legacyDate = nsPerCall(iterations, [&](size_t i) { sink = sink + legacy::isValidDate(dates[i % dates.size()]); });
+    double currentDate = nsPerCall(iterations, [&](size_t i) { sink = sink + isValidDate(dates[i % dates.size()]); });
+    report("date", legacyDate, currentDate);
+
+    double legacyTime = nsPerCall(iterations, [&](size_t i) { sink = sink + legacy::isValidAppointmentTime(times[i % times.size()]); });
+    double currentTime = nsPerCall(iterations, [&](size_t i) { sink = sink + isValidAppointmentTime(times[i % times.size()]); });
+    report("appointment time", legacyTime, currentTime);
+
+    double legacyInt = nsPerCall(iterations, [&](size_t i) { sink = sink + std::atoi(numbers[i % numbers.size()].c_str()); });
+    double currentInt = nsPerCall(iterations, [&](size_t i) {
+        int value = 0;
+        sink = sink + (parseIntParam(numbers[i % numbers.size()].c_str(), value) ? value : 0);
+    });
+    report("integer param", legacyInt, currentInt);
+
+    return sink == -1 ? 1 : 0;
+}
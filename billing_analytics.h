@@ -0,0 +1,289 @@
+#pragma once
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "database.h"
+#include "json_stream.h"
+#include "table_versions.h"
+#include "validation.h"
+
+// ------------------ Billing Analytics ------------------
+// Reports never read Bills. Triggers (migrations/0003_billing_summaries.sql) keep two summary
+// tables current: fees per (day, doctor) and insured bills per (insurer, claim status). The
+// per-day summary is held in memory column by column, ordered by day, with running totals, so
+// a date range is two binary searches plus a scan of the summary rows inside it. The cost
+// depends on the number of days and doctors, not on how many bills there are.
+
+struct BillingTotals {
+    long long bills = 0;
+    double medicationFee = 0.0;
+    double consultationFee = 0.0;
+    double surgeryFee = 0.0;
+    double totalFee = 0.0;
+
+    void add(const BillingTotals& other) {
+        bills += other.bills;
+        medicationFee += other.medicationFee;
+        consultationFee += other.consultationFee;
+        surgeryFee += other.surgeryFee;
+        totalFee += other.totalFee;
+    }
+};
+
+inline BillingTotals operator-(const BillingTotals& a, const BillingTotals& b) {
+    return {a.bills - b.bills, a.medicationFee - b.medicationFee, a.consultationFee - b.consultationFee,
+            a.surgeryFee - b.surgeryFee, a.totalFee - b.totalFee};
+}
+
+struct ClaimTotals {
+    std::string insuranceCompany;
+    std::string claimStatus;
+    long long claims;
+    double amount;
+};
+
+// "YYYY-MM-DD" as YYYYMMDD, which orders the same way; 0 if it is not a calendar date
+inline int dayKey(std::string_view date) {
+    int year = 0, month = 0, day = 0;
+    return parseDate(date, year, month, day) ? year * 10000 + month * 100 + day : 0;
+}
+
+inline std::string dayString(int key) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02d", key / 10000, key / 100 % 100, key % 100);
+    return text;
+}
+
+// Immutable snapshot of the summaries
+class BillingColumns {
+public:
+    // Reads both summary tables from one snapshot, so a bill committed between the two
+    // SELECTs cannot show up in one and not the other; false on a database error
+    bool load(DbConnection& conn) {
+        ReadTransaction snapshot(conn);
+        CachedStatement stmt = conn.prepare(
+            "SELECT date, doctorId, bills, medicationFee, consultationFee, surgeryFee, totalFee "
+            "FROM BillingDaily WHERE bills > 0 ORDER BY date, doctorId");
+        if (!stmt) {
+            return false;
+        }
+        BillingTotals running;
+        prefix_.push_back(running);
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const char* date = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            int key = date ? dayKey(date) : 0;
+            if (key == 0) {
+                continue;  // appointments stored with a malformed date cannot fall in any range
+            }
+            day_.push_back(key);
+            doctorId_.push_back(sqlite3_column_int64(stmt, 1));
+            BillingTotals row{sqlite3_column_int64(stmt, 2), sqlite3_column_double(stmt, 3),
+                              sqlite3_column_double(stmt, 4), sqlite3_column_double(stmt, 5),
+                              sqlite3_column_double(stmt, 6)};
+            bills_.push_back(row.bills);
+            medicationFee_.push_back(row.medicationFee);
+            consultationFee_.push_back(row.consultationFee);
+            surgeryFee_.push_back(row.surgeryFee);
+            totalFee_.push_back(row.totalFee);
+            running.add(row);
+            prefix_.push_back(running);
+        }
+        if (rc != SQLITE_DONE) {
+            return false;
+        }
+
+        stmt = conn.prepare(
+            "SELECT insuranceCompany, claimStatus, claims, amount FROM ClaimSummary WHERE claims > 0 "
+            "ORDER BY insuranceCompany, claimStatus");
+        if (!stmt) {
+            return false;
+        }
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            claims_.push_back({reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                               reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                               sqlite3_column_int64(stmt, 2), sqlite3_column_double(stmt, 3)});
+        }
+        return rc == SQLITE_DONE;
+    }
+
+    // Summary rows with from <= day <= to, as [first, last)
+    std::pair<size_t, size_t> range(int from, int to) const {
+        auto first = std::lower_bound(day_.begin(), day_.end(), from);
+        auto last = std::upper_bound(first, day_.end(), to);
+        return {static_cast<size_t>(first - day_.begin()), static_cast<size_t>(last - day_.begin())};
+    }
+
+    BillingTotals row(size_t i) const {
+        return {bills_[i], medicationFee_[i], consultationFee_[i], surgeryFee_[i], totalFee_[i]};
+    }
+
+    // All doctors over [first, last), from the running totals
+    BillingTotals totals(size_t first, size_t last) const { return prefix_[last] - prefix_[first]; }
+
+    int day(size_t i) const { return day_[i]; }
+    long long doctorId(size_t i) const { return doctorId_[i]; }
+    const std::vector<ClaimTotals>& claims() const { return claims_; }
+
+private:
+    std::vector<int> day_;
+    std::vector<long long> doctorId_;
+    std::vector<long long> bills_;
+    std::vector<double> medicationFee_;
+    std::vector<double> consultationFee_;
+    std::vector<double> surgeryFee_;
+    std::vector<double> totalFee_;
+    std::vector<BillingTotals> prefix_;  // prefix_[i]: rows [0, i)
+    std::vector<ClaimTotals> claims_;
+};
+
+inline void writeBillingTotals(JsonStreamWriter& writer, const BillingTotals& totals) {
+    writer.key("bills");
+    writer.value(totals.bills);
+    writer.key("medicationFee");
+    writer.value(totals.medicationFee);
+    writer.key("consultationFee");
+    writer.value(totals.consultationFee);
+    writer.key("surgeryFee");
+    writer.value(totals.surgeryFee);
+    writer.key("totalFee");
+    writer.value(totals.totalFee);
+}
+
+// {"from","to","totals":{...},"byDay":[...],"byDoctor":[...],"claimsByInsurer":[...]} for the days
+// from..to (YYYYMMDD), optionally for one doctor (doctorId > 0)
+inline void writeBillingReport(JsonStreamWriter& writer, const BillingColumns& columns, int from, int to,
+                               long long doctorId) {
+    auto [first, last] = columns.range(from, to);
+
+    BillingTotals totals = doctorId > 0 ? BillingTotals() : columns.totals(first, last);
+    std::vector<std::pair<int, BillingTotals>> byDay;
+    std::map<long long, BillingTotals> byDoctor;
+    for (size_t i = first; i < last; ++i) {
+        if (doctorId > 0 && columns.doctorId(i) != doctorId) {
+            continue;
+        }
+        BillingTotals row = columns.row(i);
+        if (doctorId > 0) {
+            totals.add(row);
+        }
+        if (byDay.empty() || byDay.back().first != columns.day(i)) {
+            byDay.emplace_back(columns.day(i), BillingTotals());
+        }
+        byDay.back().second.add(row);
+        byDoctor[columns.doctorId(i)].add(row);
+    }
+
+    writer.beginObject();
+    writer.key("from");
+    writer.value(dayString(from));
+    writer.key("to");
+    writer.value(dayString(to));
+    writer.key("totals");
+    writer.beginObject();
+    writeBillingTotals(writer, totals);
+    writer.endObject();
+
+    writer.key("byDay");
+    writer.beginArray();
+    for (const auto& [day, dayTotals] : byDay) {
+        writer.beginObject();
+        writer.key("date");
+        writer.value(dayString(day));
+        writeBillingTotals(writer, dayTotals);
+        writer.endObject();
+    }
+    writer.endArray();
+
+    writer.key("byDoctor");
+    writer.beginArray();
+    for (const auto& [id, doctorTotals] : byDoctor) {
+        writer.beginObject();
+        writer.key("doctorId");
+        writer.value(id);
+        writeBillingTotals(writer, doctorTotals);
+        writer.endObject();
+    }
+    writer.endArray();
+
+    // Claims are not dated; "Pending" rows are the outstanding ones
+    writer.key("claimsByInsurer");
+    writer.beginArray();
+    for (const ClaimTotals& claim : columns.claims()) {
+        writer.beginObject();
+        writer.key("insuranceCompany");
+        writer.value(claim.insuranceCompany);
+        writer.key("claimStatus");
+        writer.value(claim.claimStatus);
+        writer.key("claims");
+        writer.value(claim.claims);
+        writer.key("amount");
+        writer.value(claim.amount);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+// Hands out the current snapshot, rebuilding it after Bills or Appointments have changed.
+// Rebuilds are at least `refreshInterval` apart, so under a steady write load reports lag by
+// up to that long; one request rebuilds while the others keep using the previous snapshot.
+class BillingAnalytics {
+public:
+    BillingAnalytics(const TableVersions& versions, std::chrono::milliseconds refreshInterval)
+        : versions_(versions), refreshInterval_(refreshInterval) {}
+
+    BillingAnalytics(const BillingAnalytics&) = delete;
+    BillingAnalytics& operator=(const BillingAnalytics&) = delete;
+
+    // Null only if no snapshot could be loaded yet
+    std::shared_ptr<const BillingColumns> columns(DbConnection& conn) {
+        // The summaries only change along with Bills, or Appointments when one is moved, and the
+        // triggers run in the same commit
+        uint64_t version = versions_.get("Bills") + versions_.get("Appointments");
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!current_) {
+                loaded_.wait(lock, [this] { return current_ || !loading_; });
+            }
+            bool fresh = current_ && (loadedVersion_ == version || now - loadedAt_ < refreshInterval_);
+            if (fresh || loading_) {
+                return current_;
+            }
+            loading_ = true;
+        }
+
+        auto snapshot = std::make_shared<BillingColumns>();
+        bool ok = snapshot->load(conn);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        loading_ = false;
+        if (ok) {
+            current_ = std::move(snapshot);
+            loadedVersion_ = version;
+            loadedAt_ = now;
+        }
+        loaded_.notify_all();
+        return current_;
+    }
+
+private:
+    const TableVersions& versions_;
+    const std::chrono::milliseconds refreshInterval_;
+
+    std::mutex mutex_;
+    std::condition_variable loaded_;
+    std::shared_ptr<const BillingColumns> current_;
+    uint64_t loadedVersion_ = 0;
+    std::chrono::steady_clock::time_point loadedAt_;
+    bool loading_ = false;
+};
@@ -0,0 +1,319 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_stream.h"
+
+// ------------------ Binary Stream Writers ------------------
+// CBOR (RFC 8949) and MessagePack counterparts of JsonStreamWriter, with the same interface so
+// any serializer templated on the writer can emit either. Numbers are written in binary (a
+// double is 4 or 8 bytes, never formatted as text), and a double that a float holds exactly
+// is written as a float.
+
+class BinaryStreamWriter {
+public:
+    BinaryStreamWriter(const BinaryStreamWriter&) = delete;
+    BinaryStreamWriter& operator=(const BinaryStreamWriter&) = delete;
+
+    void flush() {
+        if (!buffer_.empty()) {
+            sink_.write(buffer_.data(), buffer_.size());
+            buffer_.clear();
+        }
+    }
+
+    // Flushes and signals the end of the document to the sink
+    void finish() {
+        flush();
+        sink_.finish();
+    }
+
+protected:
+    BinaryStreamWriter(ByteSink& sink, size_t bufferSize) : sink_(sink), bufferSize_(bufferSize) {
+        buffer_.reserve(bufferSize_ + 256);
+    }
+
+    void put(uint8_t byte) { buffer_ += static_cast<char>(byte); }
+
+    // `bytes` low-order bytes of `value`, big-endian as both formats require
+    void putBigEndian(uint64_t value, int bytes) {
+        for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+            put(static_cast<uint8_t>(value >> shift));
+        }
+    }
+
+    static bool fitsFloat(double number) { return static_cast<double>(static_cast<float>(number)) == number; }
+
+    static uint32_t floatBits(float number) {
+        uint32_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        return bits;
+    }
+
+    static uint64_t doubleBits(double number) {
+        uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        return bits;
+    }
+
+    void maybeFlush() {
+        if (buffer_.size() >= bufferSize_) {
+            flush();
+        }
+    }
+
+    ByteSink& sink_;
+    size_t bufferSize_;
+    std::string buffer_;
+};
+
+// CBOR with indefinite-length maps and arrays, so nothing has to be counted up front and the
+// output streams to the sink like JSON does
+class CborStreamWriter : public BinaryStreamWriter {
+public:
+    explicit CborStreamWriter(ByteSink& sink, size_t bufferSize = 64 * 1024) : BinaryStreamWriter(sink, bufferSize) {}
+
+    void beginObject() { put(0xbf); }
+    void endObject() { closeContainer(); }
+    void beginArray() { put(0x9f); }
+    void endArray() { closeContainer(); }
+
+    void key(std::string_view name) { value(name); }
+
+    void value(std::string_view text) {
+        head(3, text.size());
+        buffer_.append(text.data(), text.size());
+        maybeFlush();
+    }
+
+    void value(const char* text) {
+        if (text) {
+            value(std::string_view(text));
+        } else {
+            null();
+        }
+    }
+
+    void value(long long number) {
+        if (number >= 0) {
+            head(0, static_cast<uint64_t>(number));
+        } else {
+            head(1, static_cast<uint64_t>(-(number + 1)));
+        }
+    }
+
+    void value(int number) { value(static_cast<long long>(number)); }
+
+    void value(double number) {
+        if (fitsFloat(number)) {
+            put(0xfa);
+            putBigEndian(floatBits(static_cast<float>(number)), 4);
+        } else {
+            put(0xfb);
+            putBigEndian(doubleBits(number), 8);
+        }
+    }
+
+    void value(bool flag) { put(flag ? 0xf5 : 0xf4); }
+
+    void null() { put(0xf6); }
+
+private:
+    void closeContainer() {
+        put(0xff);  // "break"
+        maybeFlush();
+    }
+
+    void head(uint8_t major, uint64_t argument) {
+        uint8_t type = static_cast<uint8_t>(major << 5);
+        if (argument < 24) {
+            put(type | static_cast<uint8_t>(argument));
+        } else if (argument <= 0xff) {
+            put(type | 24);
+            putBigEndian(argument, 1);
+        } else if (argument <= 0xffff) {
+            put(type | 25);
+            putBigEndian(argument, 2);
+        } else if (argument <= 0xffffffff) {
+            put(type | 26);
+            putBigEndian(argument, 4);
+        } else {
+            put(type | 27);
+            putBigEndian(argument, 8);
+        }
+    }
+};
+
+// MessagePack has no indefinite-length containers: each map and array is opened with a
+// placeholder header, counted as it is filled and given its smallest header when closed (the
+// contents shift left by the bytes saved). Output can only reach the sink between top-level
+// values, so a response is buffered whole; CBOR is the format to pick for streaming.
+class MsgPackStreamWriter : public BinaryStreamWriter {
+public:
+    explicit MsgPackStreamWriter(ByteSink& sink, size_t bufferSize = 64 * 1024)
+        : BinaryStreamWriter(sink, bufferSize) {}
+
+    void beginObject() { open(true); }
+    void endObject() { close(); }
+    void beginArray() { open(false); }
+    void endArray() { close(); }
+
+    void key(std::string_view name) {
+        ++open_.back().count;
+        string(name);
+    }
+
+    void value(std::string_view text) {
+        element();
+        string(text);
+        maybeFlush();
+    }
+
+    void value(const char* text) {
+        if (text) {
+            value(std::string_view(text));
+        } else {
+            null();
+        }
+    }
+
+    void value(long long number) {
+        element();
+        if (number >= 0) {
+            if (number < 0x80) {
+                put(static_cast<uint8_t>(number));
+            } else if (number <= 0xff) {
+                put(0xcc);
+                putBigEndian(static_cast<uint64_t>(number), 1);
+            } else if (number <= 0xffff) {
+                put(0xcd);
+                putBigEndian(static_cast<uint64_t>(number), 2);
+            } else if (number <= 0xffffffffLL) {
+                put(0xce);
+                putBigEndian(static_cast<uint64_t>(number), 4);
+            } else {
+                put(0xcf);
+                putBigEndian(static_cast<uint64_t>(number), 8);
+            }
+        } else if (number >= -32) {
+            put(static_cast<uint8_t>(number));  // negative fixint
+        } else if (number >= INT8_MIN) {
+            put(0xd0);
+            putBigEndian(static_cast<uint64_t>(number), 1);
+        } else if (number >= INT16_MIN) {
+            put(0xd1);
+            putBigEndian(static_cast<uint64_t>(number), 2);
+        } else if (number >= INT32_MIN) {
+            put(0xd2);
+            putBigEndian(static_cast<uint64_t>(number), 4);
+        } else {
+            put(0xd3);
+            putBigEndian(static_cast<uint64_t>(number), 8);
+        }
+    }
+
+    void value(int number) { value(static_cast<long long>(number)); }
+
+    void value(double number) {
+        element();
+        if (fitsFloat(number)) {
+            put(0xca);
+            putBigEndian(floatBits(static_cast<float>(number)), 4);
+        } else {
+            put(0xcb);
+            putBigEndian(doubleBits(number), 8);
+        }
+    }
+
+    void value(bool flag) {
+        element();
+        put(flag ? 0xc3 : 0xc2);
+    }
+
+    void null() {
+        element();
+        put(0xc0);
+    }
+
+private:
+    struct Container {
+        size_t offset;  // of the 5-byte placeholder header
+        uint32_t count;
+        bool map;
+    };
+
+    static constexpr size_t kPlaceholderSize = 5;
+
+    // Counts a value placed directly in an array (map values were counted with their key)
+    void element() {
+        if (!open_.empty() && !open_.back().map) {
+            ++open_.back().count;
+        }
+    }
+
+    void open(bool map) {
+        element();
+        open_.push_back({buffer_.size(), 0, map});
+        buffer_.append(kPlaceholderSize, '\0');
+    }
+
+    void close() {
+        Container container = open_.back();
+        open_.pop_back();
+
+        uint8_t header[kPlaceholderSize];
+        size_t headerSize;
+        if (container.count < 16) {
+            header[0] = static_cast<uint8_t>((container.map ? 0x80 : 0x90) | container.count);
+            headerSize = 1;
+        } else if (container.count <= 0xffff) {
+            header[0] = container.map ? 0xde : 0xdc;
+            header[1] = static_cast<uint8_t>(container.count >> 8);
+            header[2] = static_cast<uint8_t>(container.count);
+            headerSize = 3;
+        } else {
+            header[0] = container.map ? 0xdf : 0xdd;
+            for (int i = 0; i < 4; ++i) {
+                header[1 + i] = static_cast<uint8_t>(container.count >> (24 - 8 * i));
+            }
+            headerSize = 5;
+        }
+
+        char* start = &buffer_[container.offset];
+        size_t contentSize = buffer_.size() - container.offset - kPlaceholderSize;
+        std::memmove(start + headerSize, start + kPlaceholderSize, contentSize);
+        std::memcpy(start, header, headerSize);
+        buffer_.resize(container.offset + headerSize + contentSize);
+
+        if (open_.empty()) {
+            maybeFlush();
+        }
+    }
+
+    void string(std::string_view text) {
+        size_t size = text.size();
+        if (size < 32) {
+            put(static_cast<uint8_t>(0xa0 | size));
+        } else if (size <= 0xff) {
+            put(0xd9);
+            putBigEndian(size, 1);
+        } else if (size <= 0xffff) {
+            put(0xda);
+            putBigEndian(size, 2);
+        } else {
+            put(0xdb);
+            putBigEndian(size, 4);
+        }
+        buffer_.append(text.data(), size);
+    }
+
+    void maybeFlush() {
+        if (open_.empty()) {
+            BinaryStreamWriter::maybeFlush();
+        }
+    }
+
+    std::vector<Container> open_;
+};
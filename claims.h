@@ -0,0 +1,363 @@
+#pragma once
+#include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "database.h"
+#include "write_queue.h"
+
+// ------------------ Insurance Claims ------------------
+// Claim lifecycle on Bills.claimStatus:
+//   'Not Submitted' --submitClaim--> 'Pending' --decideClaim--> 'Approved' | 'Rejected'
+// Every transition is one UPDATE conditioned on the expected current state, so a manual
+// approval and the background adjudicator racing on the same bill cannot both apply: the
+// loser changes no row and reports the state the bill is actually in.
+
+enum class ClaimDecision { Approved, Rejected };
+
+enum class ClaimResult { Ok, NotFound, NotInsured, AlreadyClaimed, NotPending, Failed };
+
+inline const char* claimStatusName(ClaimDecision decision) {
+    return decision == ClaimDecision::Approved ? "Approved" : "Rejected";
+}
+
+inline int claimResultStatus(ClaimResult result) {
+    switch (result) {
+    case ClaimResult::Ok:
+        return 200;
+    case ClaimResult::NotFound:
+        return 404;
+    case ClaimResult::Failed:
+        return 500;
+    default:
+        return 400;
+    }
+}
+
+inline const char* claimResultMessage(ClaimResult result) {
+    switch (result) {
+    case ClaimResult::Ok:
+        return "OK";
+    case ClaimResult::NotFound:
+        return "Bill not found";
+    case ClaimResult::NotInsured:
+        return "This bill is not for an insured patient";
+    case ClaimResult::AlreadyClaimed:
+        return "This bill has already been claimed";
+    case ClaimResult::NotPending:
+        return "Claim is not in a pending state";
+    case ClaimResult::Failed:
+        break;
+    }
+    return "Failed to update claim status";
+}
+
+// Why a conditional transition on `billId` changed no row
+inline ClaimResult diagnoseClaim(DbConnection& conn, long long billId, bool submitting) {
+    CachedStatement stmt = conn.prepare("SELECT isInsured, claimed FROM Bills WHERE id = ?");
+    if (!stmt) {
+        return ClaimResult::Failed;
+    }
+    sqlite3_bind_int64(stmt, 1, billId);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_DONE) {
+        return ClaimResult::NotFound;
+    }
+    if (rc != SQLITE_ROW) {
+        return ClaimResult::Failed;
+    }
+    if (!submitting) {
+        return ClaimResult::NotPending;
+    }
+    return sqlite3_column_int(stmt, 0) == 0 ? ClaimResult::NotInsured : ClaimResult::AlreadyClaimed;
+}
+
+// Files the insurance claim for an insured, unclaimed bill
+inline ClaimResult submitClaim(DbConnection& conn, long long billId) {
+    {
+        CachedStatement stmt = conn.prepare(
+            "UPDATE Bills SET claimed = 1, claimStatus = 'Pending' WHERE id = ? AND isInsured = 1 AND claimed = 0");
+        if (!stmt) {
+            return ClaimResult::Failed;
+        }
+        sqlite3_bind_int64(stmt, 1, billId);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            return ClaimResult::Failed;
+        }
+    }
+    return sqlite3_changes(conn.handle()) == 1 ? ClaimResult::Ok : diagnoseClaim(conn, billId, true);
+}
+
+// Settles a pending claim
+inline ClaimResult decideClaim(DbConnection& conn, long long billId, ClaimDecision decision) {
+    {
+        CachedStatement stmt = conn.prepare("UPDATE Bills SET claimStatus = ? WHERE id = ? AND claimStatus = 'Pending'");
+        if (!stmt) {
+            return ClaimResult::Failed;
+        }
+        sqlite3_bind_text(stmt, 1, claimStatusName(decision), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, billId);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            return ClaimResult::Failed;
+        }
+    }
+    return sqlite3_changes(conn.handle()) == 1 ? ClaimResult::Ok : diagnoseClaim(conn, billId, false);
+}
+
+// ------------------ Insurers ------------------
+
+struct Claim {
+    long long billId;
+    long long patientId;
+    double totalFee;
+    std::string insuranceCompany;
+};
+
+// Adjudicates claims with an insurer. Returns one decision per claim, in order; throws if the
+// insurer could not be reached, and the claims stay pending for the next run.
+class InsurerGateway {
+public:
+    virtual ~InsurerGateway() = default;
+    virtual std::vector<ClaimDecision> adjudicate(const std::vector<Claim>& claims) = 0;
+};
+
+// In-process stand-in for the insurers: approves claims up to a coverage limit, after an
+// optional simulated round trip per batch
+class LocalInsurerStub : public InsurerGateway {
+public:
+    explicit LocalInsurerStub(double coverageLimit = 10000.0,
+                              std::chrono::microseconds latency = std::chrono::microseconds(0))
+        : coverageLimit_(coverageLimit), latency_(latency) {}
+
+    std::vector<ClaimDecision> adjudicate(const std::vector<Claim>& claims) override {
+        if (latency_.count() > 0) {
+            std::this_thread::sleep_for(latency_);
+        }
+        std::vector<ClaimDecision> decisions;
+        decisions.reserve(claims.size());
+        for (const Claim& claim : claims) {
+            bool covered = !claim.insuranceCompany.empty() && claim.totalFee <= coverageLimit_;
+            decisions.push_back(covered ? ClaimDecision::Approved : ClaimDecision::Rejected);
+        }
+        return decisions;
+    }
+
+private:
+    double coverageLimit_;
+    std::chrono::microseconds latency_;
+};
+
+// ------------------ Claim Processor ------------------
+// Adjudicates pending claims in the background. A dispatcher thread pages through the
+// pending bills (keyset on the claimStatus index) and hands out batches; a pool of workers
+// sends each batch to the insurer and applies its decisions as one job on the write queue.
+// A pass ends once every batch it dispatched is settled, so no claim is in two batches.
+
+class ClaimProcessor {
+public:
+    ClaimProcessor(ConnectionPool& pool, WriteQueue& queue, InsurerGateway& insurer, int workers, int batchSize,
+                   std::chrono::milliseconds interval)
+        : pool_(pool), queue_(queue), insurer_(insurer), batchSize_(batchSize > 0 ? batchSize : 1),
+          maxQueued_(workers > 0 ? 2 * static_cast<size_t>(workers) : 2), interval_(interval) {
+        for (int i = 0; i < (workers > 0 ? workers : 1); ++i) {
+            workers_.emplace_back([this] { work(); });
+        }
+        dispatcher_ = std::thread([this] { dispatch(); });
+    }
+
+    ClaimProcessor(const ClaimProcessor&) = delete;
+    ClaimProcessor& operator=(const ClaimProcessor&) = delete;
+
+    ~ClaimProcessor() { stop(); }
+
+    // Starts a pass now instead of at the next interval, e.g. after claims were submitted
+    void kick() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            kicked_ = true;
+        }
+        changed_.notify_all();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_all();
+        if (dispatcher_.joinable()) {
+            dispatcher_.join();
+        }
+        for (std::thread& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    long long approved() const { return approved_.load(std::memory_order_relaxed); }
+    long long rejected() const { return rejected_.load(std::memory_order_relaxed); }
+    // Decisions that lost to a concurrent transition (e.g. a manual approval)
+    long long conflicts() const { return conflicts_.load(std::memory_order_relaxed); }
+
+private:
+    void dispatch() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            changed_.wait_for(lock, interval_, [this] { return stopping_ || kicked_; });
+            if (stopping_) {
+                return;
+            }
+            kicked_ = false;
+            lock.unlock();
+            bool ok = dispatchPass();
+            lock.lock();
+            // Wait for this pass to settle before rescanning, so no claim is handed out twice
+            changed_.wait(lock, [this] { return stopping_ || (batches_.empty() && busyWorkers_ == 0); });
+            if (!ok) {
+                std::cerr << "Claim processing pass failed; will retry" << std::endl;
+            }
+        }
+    }
+
+    // Queues every pending claim in batches; false on a read error
+    bool dispatchPass() {
+        DbConnection& conn = pool_.local();
+        long long afterId = 0;
+        while (true) {
+            std::vector<Claim> batch;
+            {
+                CachedStatement stmt = conn.prepare(
+                    "SELECT id, patientId, totalFee, insuranceCompany FROM Bills "
+                    "WHERE claimStatus = 'Pending' AND id > ? ORDER BY id LIMIT ?");
+                if (!stmt) {
+                    return false;
+                }
+                sqlite3_bind_int64(stmt, 1, afterId);
+                sqlite3_bind_int(stmt, 2, batchSize_);
+                int rc;
+                while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                    const unsigned char* insurer = sqlite3_column_text(stmt, 3);
+                    batch.push_back({sqlite3_column_int64(stmt, 0), sqlite3_column_int64(stmt, 1),
+                                     sqlite3_column_double(stmt, 2),
+                                     insurer ? reinterpret_cast<const char*>(insurer) : ""});
+                }
+                if (rc != SQLITE_DONE) {
+                    return false;
+                }
+            }
+            if (batch.empty()) {
+                return true;
+            }
+            afterId = batch.back().billId;
+            bool last = batch.size() < static_cast<size_t>(batchSize_);
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [this] { return stopping_ || batches_.size() < maxQueued_; });
+            if (stopping_) {
+                return true;
+            }
+            batches_.push_back(std::move(batch));
+            changed_.notify_all();
+            if (last) {
+                return true;
+            }
+        }
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            changed_.wait(lock, [this] { return stopping_ || !batches_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            std::vector<Claim> batch = std::move(batches_.front());
+            batches_.pop_front();
+            ++busyWorkers_;
+            changed_.notify_all();
+            lock.unlock();
+
+            settle(batch);
+
+            lock.lock();
+            --busyWorkers_;
+            changed_.notify_all();
+        }
+    }
+
+    void settle(const std::vector<Claim>& batch) {
+        std::vector<ClaimDecision> decisions;
+        try {
+            decisions = insurer_.adjudicate(batch);
+        } catch (const std::exception& e) {
+            std::cerr << "Insurer unavailable, " << batch.size() << " claims stay pending: " << e.what() << std::endl;
+            return;
+        }
+        if (decisions.size() != batch.size()) {
+            std::cerr << "Insurer answered " << decisions.size() << " of " << batch.size() << " claims" << std::endl;
+            return;
+        }
+
+        long long approved = 0, rejected = 0, conflicts = 0;
+        bool committed = false;
+        try {
+            committed = queue_.submit([&](DbConnection& conn) {
+                approved = rejected = conflicts = 0;
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    ClaimResult result = decideClaim(conn, batch[i].billId, decisions[i]);
+                    if (result == ClaimResult::Failed) {
+                        return false;
+                    }
+                    if (result != ClaimResult::Ok) {
+                        ++conflicts;
+                    } else if (decisions[i] == ClaimDecision::Approved) {
+                        ++approved;
+                    } else {
+                        ++rejected;
+                    }
+                }
+                return true;
+            }).get();
+        } catch (const std::exception& e) {
+            // The job threw on the writer (or could not be queued); nothing was recorded
+            std::cerr << "Failed to record " << batch.size() << " claim decisions; they stay pending: " << e.what()
+                      << std::endl;
+            return;
+        }
+        if (!committed) {
+            std::cerr << "Could not record " << batch.size() << " claim decisions; they stay pending" << std::endl;
+            return;
+        }
+        approved_.fetch_add(approved, std::memory_order_relaxed);
+        rejected_.fetch_add(rejected, std::memory_order_relaxed);
+        conflicts_.fetch_add(conflicts, std::memory_order_relaxed);
+    }
+
+    ConnectionPool& pool_;
+    WriteQueue& queue_;
+    InsurerGateway& insurer_;
+    const int batchSize_;
+    const size_t maxQueued_;
+    const std::chrono::milliseconds interval_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;  // any change to the fields below
+    std::deque<std::vector<Claim>> batches_;
+    int busyWorkers_ = 0;
+    bool kicked_ = false;
+    bool stopping_ = false;
+
+    std::atomic<long long> approved_{0};
+    std::atomic<long long> rejected_{0};
+    std::atomic<long long> conflicts_{0};
+    std::vector<std::thread> workers_;
+    std::thread dispatcher_;
+};
@@ -0,0 +1,562 @@
+#pragma once
+#include <sqlite3.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "storage_profile.h"
+
+// ------------------ Schema ------------------
+inline sqlite3* initDatabase(const std::string& dbPath, const std::string& schemaPath,
+                             const StorageProfile& profile = StorageProfile()) {
+    sqlite3* db;
+
+    // Open the SQLite database
+    if (sqlite3_open(dbPath.c_str(), &db)) {
+        throw std::runtime_error("Cannot open database: " + std::string(sqlite3_errmsg(db)));
+    }
+
+    // Load the schema file
+    std::ifstream schemaFile(schemaPath);
+    if (!schemaFile.is_open()) {
+        sqlite3_close(db);
+        throw std::runtime_error("Cannot open schema file: " + schemaPath);
+    }
+
+    std::stringstream buffer;
+    buffer << schemaFile.rdbuf();
+    std::string schema = buffer.str();
+    schemaFile.close();
+
+    // The journal mode is persistent, so setting it once here covers every pooled connection.
+    // With WAL (the default profile) readers keep running while a writer is active.
+    char* errMsg = nullptr;
+    std::string journalMode = "PRAGMA journal_mode=" + profile.journalMode;
+    if (sqlite3_exec(db, journalMode.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Could not set journal mode " << profile.journalMode << ": " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        errMsg = nullptr;
+    }
+    try {
+        applyConnectionPragmas(db, profile);
+    } catch (const std::exception&) {
+        sqlite3_close(db);
+        throw;
+    }
+
+    // Execute the schema to create tables
+    if (sqlite3_exec(db, schema.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::string error = errMsg;
+        sqlite3_free(errMsg);
+        sqlite3_close(db);
+        throw std::runtime_error("Failed to execute schema: " + error);
+    }
+
+    std::cout << "Database initialized successfully with schema." << std::endl;
+    return db;
+}
+
+// Data a migration cannot fix by itself. Before a script runs, its checks are queried and any
+// rows they return stop startup with a listing, so an operator can resolve them by hand
+// instead of reading a bare constraint error.
+struct MigrationCheck {
+    int version;
+    const char* problem;  // what the rows are and what to do about them
+    const char* sql;      // each row is one conflicting record
+};
+
+inline const std::vector<MigrationCheck>& migrationChecks() {
+    static const std::vector<MigrationCheck> checks = {
+        // The unique slot index in 0001 cannot be built over double bookings, and they cannot be
+        // merged or dropped automatically: each belongs to a patient and may have a bill
+        {1,
+         "Appointments double-book a doctor's slot (doctorId, date, time). Move or cancel all but one "
+         "appointment per slot, and repoint or remove their bills, then restart.",
+         "SELECT 'appointment ' || a.id || ': doctor ' || a.doctorId || ' at ' || a.date || ' ' || a.time || "
+         "', patient ' || a.patientId || COALESCE(', bills ' || (SELECT group_concat(b.id, ',') FROM Bills b "
+         "WHERE b.appointmentId = a.id), '') "
+         "FROM Appointments a JOIN (SELECT doctorId, date, time FROM Appointments GROUP BY doctorId, date, time "
+         "HAVING count(*) > 1) d ON d.doctorId = a.doctorId AND d.date = a.date AND d.time = a.time "
+         "ORDER BY a.doctorId, a.date, a.time, a.id"},
+    };
+    return checks;
+}
+
+// Throws with the rows the checks for `version` report, if any
+inline void runMigrationChecks(sqlite3* db, int version, const std::string& scriptName) {
+    constexpr int kMaxReportedRows = 100;
+    for (const MigrationCheck& check : migrationChecks()) {
+        if (check.version != version) {
+            continue;
+        }
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, check.sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error("Failed to check migration " + scriptName + ": " + sqlite3_errmsg(db));
+        }
+        std::string report;
+        int rows = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            if (++rows <= kMaxReportedRows) {
+                const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+                report += "\n  ";
+                report += text ? text : "";
+            }
+        }
+        sqlite3_finalize(stmt);
+        if (rows > 0) {
+            if (rows > kMaxReportedRows) {
+                report += "\n  ... and " + std::to_string(rows - kMaxReportedRows) + " more";
+            }
+            throw std::runtime_error("Cannot apply migration " + scriptName + ": " + check.problem + report);
+        }
+    }
+}
+
+// Applies numbered migration scripts (e.g. migrations/0001_hot_path_indexes.sql) newer than
+// the database's user_version, each in its own transaction, in ascending order.
+inline void applyMigrations(sqlite3* db, const std::string& migrationsDir) {
+    std::vector<std::pair<int, std::filesystem::path>> scripts;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(migrationsDir, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (entry.path().extension() != ".sql" || name.empty() || !std::isdigit(static_cast<unsigned char>(name[0]))) {
+            continue;
+        }
+        scripts.emplace_back(std::stoi(name), entry.path());
+    }
+    if (ec) {
+        throw std::runtime_error("Cannot read migrations directory: " + migrationsDir);
+    }
+    std::sort(scripts.begin(), scripts.end());
+
+    int currentVersion = 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            currentVersion = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    for (const auto& script : scripts) {
+        if (script.first <= currentVersion) {
+            continue;
+        }
+        runMigrationChecks(db, script.first, script.second.filename().string());
+        std::ifstream file(script.second);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+
+        std::string sql = "BEGIN IMMEDIATE;\n" + buffer.str() +
+                          "\nPRAGMA user_version = " + std::to_string(script.first) + ";\nCOMMIT;";
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            std::string error = errMsg ? errMsg : "unknown error";
+            sqlite3_free(errMsg);
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            throw std::runtime_error("Failed to apply migration " + script.second.filename().string() + ": " + error);
+        }
+        currentVersion = script.first;
+        std::cout << "Applied migration " << script.second.filename().string() << std::endl;
+    }
+}
+
+// ------------------ Prepared Statement Cache ------------------
+
+// A prepared statement borrowed from a connection's cache. The statement is reset
+// and its bindings cleared when the handle goes out of scope, so the next borrower
+// starts clean. Converts implicitly to sqlite3_stmt* for use with the sqlite3_* API.
+class CachedStatement {
+public:
+    CachedStatement() = default;
+    CachedStatement(sqlite3_stmt* stmt, bool* inUse) : stmt_(stmt), inUse_(inUse) {}
+    CachedStatement(const CachedStatement&) = delete;
+    CachedStatement& operator=(const CachedStatement&) = delete;
+    CachedStatement(CachedStatement&& other) noexcept
+        : stmt_(std::exchange(other.stmt_, nullptr)), inUse_(std::exchange(other.inUse_, nullptr)) {}
+    CachedStatement& operator=(CachedStatement&& other) noexcept {
+        if (this != &other) {
+            release();
+            stmt_ = std::exchange(other.stmt_, nullptr);
+            inUse_ = std::exchange(other.inUse_, nullptr);
+        }
+        return *this;
+    }
+    ~CachedStatement() { release(); }
+
+    operator sqlite3_stmt*() const { return stmt_; }
+
+private:
+    void release() {
+        if (!stmt_) {
+            return;
+        }
+        sqlite3_reset(stmt_);
+        sqlite3_clear_bindings(stmt_);
+        if (inUse_) {
+            *inUse_ = false;
+        } else {
+            // Overflow statement prepared because the cached one was already borrowed
+            sqlite3_finalize(stmt_);
+        }
+        stmt_ = nullptr;
+        inUse_ = nullptr;
+    }
+
+    sqlite3_stmt* stmt_ = nullptr;
+    bool* inUse_ = nullptr;
+};
+
+// One SQLite connection plus its statement cache, keyed by SQL text.
+// A connection is only ever used by the thread that owns it.
+class DbConnection {
+public:
+    DbConnection(const std::string& dbPath, const StorageProfile& profile) {
+        int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+        if (sqlite3_open_v2(dbPath.c_str(), &db_, flags, nullptr) != SQLITE_OK) {
+            std::string error = sqlite3_errmsg(db_);
+            sqlite3_close(db_);
+            throw std::runtime_error("Cannot open database: " + error);
+        }
+        try {
+            // Includes the busy timeout, so writers on other connections are waited for instead of SQLITE_BUSY
+            applyConnectionPragmas(db_, profile);
+        } catch (const std::exception&) {
+            sqlite3_close(db_);
+            throw;
+        }
+    }
+
+    DbConnection(const DbConnection&) = delete;
+    DbConnection& operator=(const DbConnection&) = delete;
+
+    ~DbConnection() {
+        for (auto& entry : statements_) {
+            sqlite3_finalize(entry.second.stmt);
+        }
+        sqlite3_close(db_);
+    }
+
+    sqlite3* handle() const { return db_; }
+
+    // Returns the cached statement for `sql`, compiling it on first use.
+    // Converts to a null sqlite3_stmt* if the SQL fails to prepare.
+    CachedStatement prepare(const std::string& sql) {
+        auto it = statements_.find(sql);
+        if (it != statements_.end()) {
+            if (!it->second.inUse) {
+                it->second.inUse = true;
+                return CachedStatement(it->second.stmt, &it->second.inUse);
+            }
+            // Same SQL borrowed twice on this thread: hand out a one-off statement
+            sqlite3_stmt* stmt = compile(sql, 0);
+            return stmt ? CachedStatement(stmt, nullptr) : CachedStatement();
+        }
+
+        sqlite3_stmt* stmt = compile(sql, SQLITE_PREPARE_PERSISTENT);
+        if (!stmt) {
+            return CachedStatement();
+        }
+        Entry& entry = statements_[sql];
+        entry.stmt = stmt;
+        entry.inUse = true;
+        return CachedStatement(stmt, &entry.inUse);
+    }
+
+    size_t cachedStatementCount() const { return statements_.size(); }
+
+    // Called with the compile time of every statement prepared on this connection
+    void onPrepare(std::function<void(std::chrono::nanoseconds)> observer) { prepareObserver_ = std::move(observer); }
+
+    // Registers an action that undoes in-memory side effects (e.g. a schedule reservation)
+    // if the enclosing transaction or savepoint rolls back. Dropped once the outermost
+    // transaction commits. Ignored outside a transaction.
+    void onRollback(std::function<void()> action) {
+        if (sqlite3_get_autocommit(db_) == 0) {
+            rollbackActions_.push_back(std::move(action));
+        }
+    }
+
+    size_t rollbackMark() const { return rollbackActions_.size(); }
+
+    // Runs (newest first) and drops the actions registered after `mark`
+    void runRollbackActions(size_t mark) {
+        while (rollbackActions_.size() > mark) {
+            auto action = std::move(rollbackActions_.back());
+            rollbackActions_.pop_back();
+            action();
+        }
+    }
+
+    void clearRollbackActions() { rollbackActions_.clear(); }
+
+private:
+    struct Entry {
+        sqlite3_stmt* stmt = nullptr;
+        bool inUse = false;
+    };
+
+    sqlite3_stmt* compile(const std::string& sql, unsigned flags) {
+        auto start = std::chrono::steady_clock::now();
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v3(db_, sql.c_str(), static_cast<int>(sql.size()), flags, &stmt, nullptr) != SQLITE_OK) {
+            sqlite3_finalize(stmt);
+            stmt = nullptr;
+        }
+        if (prepareObserver_) {
+            prepareObserver_(std::chrono::steady_clock::now() - start);
+        }
+        return stmt;
+    }
+
+    sqlite3* db_ = nullptr;
+    std::unordered_map<std::string, Entry> statements_;
+    std::vector<std::function<void()>> rollbackActions_;
+    std::function<void(std::chrono::nanoseconds)> prepareObserver_;
+};
+
+// ------------------ Transactions ------------------
+
+// Scoped write transaction: BEGIN IMMEDIATE takes the write lock up front, so the statements
+// inside never hit a lock upgrade deadlock. Rolled back on scope exit unless commit() succeeded.
+// Opened inside an existing transaction it becomes a SAVEPOINT, so transactional helpers nest.
+class Transaction {
+public:
+    explicit Transaction(DbConnection& conn)
+        : conn_(conn), nested_(sqlite3_get_autocommit(conn.handle()) == 0), mark_(conn.rollbackMark()) {
+        active_ = exec(nested_ ? "SAVEPOINT txn" : "BEGIN IMMEDIATE");
+    }
+
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+
+    ~Transaction() {
+        if (active_) {
+            rollback();
+        }
+    }
+
+    // False if the transaction could not be started (e.g. the write lock timed out)
+    bool ok() const { return active_; }
+
+    bool commit() {
+        if (!active_) {
+            return false;
+        }
+        if (!exec(nested_ ? "RELEASE txn" : "COMMIT")) {
+            rollback();
+            return false;
+        }
+        // A released savepoint's undo actions still belong to the enclosing transaction
+        if (!nested_) {
+            conn_.clearRollbackActions();
+        }
+        active_ = false;
+        return true;
+    }
+
+    void rollback() {
+        if (!active_) {
+            return;
+        }
+        if (nested_) {
+            exec("ROLLBACK TO txn");
+            exec("RELEASE txn");
+        } else if (sqlite3_get_autocommit(conn_.handle()) == 0) {
+            exec("ROLLBACK");
+        }
+        conn_.runRollbackActions(mark_);
+        active_ = false;
+    }
+
+private:
+    bool exec(const char* sql) {
+        CachedStatement stmt = conn_.prepare(sql);
+        return stmt && sqlite3_step(stmt) == SQLITE_DONE;
+    }
+
+    DbConnection& conn_;
+    bool nested_;
+    size_t mark_;
+    bool active_ = false;
+};
+
+// Scoped read snapshot: every statement run before it goes out of scope sees the same committed
+// state, without blocking the writer (WAL). Inside an open transaction it adds nothing.
+class ReadTransaction {
+public:
+    explicit ReadTransaction(DbConnection& conn)
+        : conn_(conn), active_(sqlite3_get_autocommit(conn.handle()) != 0 && exec("BEGIN")) {}
+
+    ReadTransaction(const ReadTransaction&) = delete;
+    ReadTransaction& operator=(const ReadTransaction&) = delete;
+
+    ~ReadTransaction() {
+        if (active_) {
+            exec("COMMIT");
+        }
+    }
+
+private:
+    bool exec(const char* sql) {
+        CachedStatement stmt = conn_.prepare(sql);
+        return stmt && sqlite3_step(stmt) == SQLITE_DONE;
+    }
+
+    DbConnection& conn_;
+    bool active_;
+};
+
+// Binds a string_view without copying; the text must outlive the statement's next step
+inline int bindText(sqlite3_stmt* stmt, int index, std::string_view text) {
+    return sqlite3_bind_text(stmt, index, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+}
+
+// True if the last failed step on `conn` violated a UNIQUE or PRIMARY KEY constraint
+inline bool isUniqueViolation(DbConnection& conn) {
+    int code = sqlite3_extended_errcode(conn.handle());
+    return code == SQLITE_CONSTRAINT_UNIQUE || code == SQLITE_CONSTRAINT_PRIMARYKEY;
+}
+
+// ------------------ Connection Pool ------------------
+
+// Hands each thread (one per Crow worker) its own connection, opened lazily on first use.
+// Threads never share a connection, so SQLite's per-connection mutex is never contended
+// and WAL readers proceed in parallel.
+class ConnectionPool {
+public:
+    ConnectionPool(std::string dbPath, StorageProfile profile)
+        : dbPath_(std::move(dbPath)), profile_(std::move(profile)), poolId_(nextPoolId().fetch_add(1) + 1) {}
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Connection owned by the calling thread
+    DbConnection& local() {
+        thread_local std::uint64_t cachedPoolId = 0;
+        thread_local DbConnection* cachedConnection = nullptr;
+        if (cachedPoolId == poolId_) {
+            return *cachedConnection;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = connections_[std::this_thread::get_id()];
+        if (!slot) {
+            slot = std::make_unique<DbConnection>(dbPath_, profile_);
+            if (onOpen_) {
+                onOpen_(*slot);
+            }
+        }
+        cachedPoolId = poolId_;
+        cachedConnection = slot.get();
+        return *slot;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connections_.size();
+    }
+
+    // Runs on every connection opened from now on, on the thread that will own it
+    void onOpen(std::function<void(DbConnection&)> setup) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        onOpen_ = std::move(setup);
+    }
+
+    const std::string& path() const { return dbPath_; }
+    const StorageProfile& profile() const { return profile_; }
+
+private:
+    static std::atomic<std::uint64_t>& nextPoolId() {
+        static std::atomic<std::uint64_t> id{0};
+        return id;
+    }
+
+    std::string dbPath_;
+    StorageProfile profile_;
+    std::uint64_t poolId_;
+    std::mutex mutex_;
+    std::unordered_map<std::thread::id, std::unique_ptr<DbConnection>> connections_;
+    std::function<void(DbConnection&)> onOpen_;
+};
+
+// ------------------ Background Checkpoints ------------------
+
+// Runs WAL checkpoints on a dedicated connection so request threads never pay for them.
+// Each tick does a PASSIVE checkpoint (never waits on readers); once the WAL has grown past
+// the profile's threshold it escalates to TRUNCATE to reclaim the file.
+class CheckpointWorker {
+public:
+    CheckpointWorker(const std::string& dbPath, const StorageProfile& profile)
+        : profile_(profile), connection_(dbPath, profile) {
+        if (profile_.backgroundCheckpoints()) {
+            thread_ = std::thread([this] { run(); });
+        }
+    }
+
+    CheckpointWorker(const CheckpointWorker&) = delete;
+    CheckpointWorker& operator=(const CheckpointWorker&) = delete;
+
+    ~CheckpointWorker() { stop(); }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    void run() {
+        sqlite3* db = connection_.handle();
+        long long pageSize = 4096;
+        {
+            CachedStatement stmt = connection_.prepare("PRAGMA page_size");
+            if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+                pageSize = sqlite3_column_int64(stmt, 0);
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, std::chrono::milliseconds(profile_.checkpointIntervalMs),
+                               [this] { return stopping_; })) {
+            lock.unlock();
+            int walFrames = 0, checkpointed = 0;
+            int rc = sqlite3_wal_checkpoint_v2(db, nullptr, SQLITE_CHECKPOINT_PASSIVE, &walFrames, &checkpointed);
+            if (rc == SQLITE_OK && walFrames * pageSize > profile_.checkpointTruncateBytes) {
+                rc = sqlite3_wal_checkpoint_v2(db, nullptr, SQLITE_CHECKPOINT_TRUNCATE, &walFrames, &checkpointed);
+            }
+            if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED) {
+                std::cerr << "WAL checkpoint failed: " << sqlite3_errmsg(db) << std::endl;
+            }
+            lock.lock();
+        }
+    }
+
+    StorageProfile profile_;
+    DbConnection connection_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+// ------------------ Entity Cache ------------------
+// Concurrent LRU cache split into independently locked shards, so lookups of different keys
+// rarely contend. Values can be std::optional<T> to remember that a row does not exist
+// (negative entries). Writers call erase() after their change commits; loads that raced with
+// an erase of the same shard are not cached, so a stale row read before the commit can never
+// be inserted after the invalidation.
+
+template <typename Key, typename Value, size_t Shards = 16>
+class ShardedLruCache {
+public:
+    // `capacity` is the total number of entries, spread evenly over the shards
+    explicit ShardedLruCache(size_t capacity) : perShard_(capacity / Shards > 0 ? capacity / Shards : 1) {}
+
+    ShardedLruCache(const ShardedLruCache&) = delete;
+    ShardedLruCache& operator=(const ShardedLruCache&) = delete;
+
+    // Cached value for `key`, or the result of `loader()` (run without any lock held)
+    template <typename Loader>
+    Value getOrLoad(const Key& key, Loader loader) {
+        Shard& shard = shardFor(key);
+        uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second->second;
+            }
+            generation = shard.generation;
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+
+        Value value = loader();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.generation == generation) {
+            insertLocked(shard, key, value);
+        }
+        return value;
+    }
+
+    std::optional<Value> find(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return it->second->second;
+    }
+
+    void put(const Key& key, const Value& value) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        insertLocked(shard, key, value);
+    }
+
+    void erase(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ++shard.generation;
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.entries.erase(it->second);
+            shard.index.erase(it);
+        }
+    }
+
+    void clear() {
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            ++shard.generation;
+            shard.entries.clear();
+            shard.index.clear();
+        }
+    }
+
+    long long hits() const { return hits_.load(std::memory_order_relaxed); }
+    long long misses() const { return misses_.load(std::memory_order_relaxed); }
+
+    size_t size() {
+        size_t total = 0;
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.index.size();
+        }
+        return total;
+    }
+
+private:
+    using Entry = std::pair<Key, Value>;
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> entries;  // most recently used first
+        std::unordered_map<Key, typename std::list<Entry>::iterator> index;
+        uint64_t generation = 0;   // bumped by every erase
+    };
+
+    Shard& shardFor(const Key& key) { return shards_[std::hash<Key>()(key) % Shards]; }
+
+    void insertLocked(Shard& shard, const Key& key, const Value& value) {
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->second = value;
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+        shard.entries.emplace_front(key, value);
+        shard.index.emplace(key, shard.entries.begin());
+        if (shard.index.size() > perShard_) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+    }
+
+    size_t perShard_;
+    std::array<Shard, Shards> shards_;
+    std::atomic<long long> hits_{0};
+    std::atomic<long long> misses_{0};
+};
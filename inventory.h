@@ -0,0 +1,202 @@
+#pragma once
+#include <sqlite3.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "database.h"
+#include "notification_feed.h"
+#include "table_versions.h"
+#include "write_queue.h"
+
+// ------------------ Inventory ------------------
+// Stock changes are single UPSERT/UPDATE statements, so concurrent adjustments of the same
+// item never lose updates; the CHECK (quantity >= 0) constraint rejects overdrawing. Low-stock
+// alerts are not written by the adjustments themselves: a background evaluator raises one
+// notification per item when it drops below the threshold and re-arms it once restocked.
+
+constexpr int kLowStockThreshold = 10;
+
+enum class StockResult { Ok, UnknownItem, InsufficientStock, Failed };
+
+inline StockResult stepStockStatement(DbConnection& conn, sqlite3_stmt* stmt, long long& quantity) {
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        quantity = sqlite3_column_int64(stmt, 0);
+        return StockResult::Ok;
+    }
+    if (rc == SQLITE_DONE) {
+        return StockResult::UnknownItem;
+    }
+    return sqlite3_extended_errcode(conn.handle()) == SQLITE_CONSTRAINT_CHECK ? StockResult::InsufficientStock
+                                                                              : StockResult::Failed;
+}
+
+// Sets the absolute quantity, adding the item if it is new
+inline StockResult setStock(DbConnection& conn, std::string_view itemName, long long quantity, long long& newQuantity) {
+    CachedStatement stmt = conn.prepare(
+        "INSERT INTO Inventory (itemName, quantity) VALUES (?1, ?2) "
+        "ON CONFLICT(itemName) DO UPDATE SET quantity = excluded.quantity RETURNING quantity");
+    if (!stmt) {
+        return StockResult::Failed;
+    }
+    bindText(stmt, 1, itemName);
+    sqlite3_bind_int64(stmt, 2, quantity);
+    return stepStockStatement(conn, stmt, newQuantity);
+}
+
+// Adds `delta` (negative to dispense). Restocking adds unknown items; dispensing requires the
+// item to exist and to hold enough stock.
+inline StockResult adjustStock(DbConnection& conn, std::string_view itemName, long long delta, long long& newQuantity) {
+    CachedStatement stmt = delta >= 0
+        ? conn.prepare("INSERT INTO Inventory (itemName, quantity) VALUES (?1, ?2) "
+                       "ON CONFLICT(itemName) DO UPDATE SET quantity = quantity + ?2 RETURNING quantity")
+        : conn.prepare("UPDATE Inventory SET quantity = quantity + ?2 WHERE itemName = ?1 RETURNING quantity");
+    if (!stmt) {
+        return StockResult::Failed;
+    }
+    bindText(stmt, 1, itemName);
+    sqlite3_bind_int64(stmt, 2, delta);
+    return stepStockStatement(conn, stmt, newQuantity);
+}
+
+// Records a low-stock notification for the item and appends it to `raised`; false if it
+// could not be written
+inline bool checkAndNotifyLowStock(const std::string& itemName, long long quantity, DbConnection& conn,
+                                   std::vector<Notification>& raised) {
+    if (quantity >= kLowStockThreshold) {
+        return true;
+    }
+    std::string message = "Low stock warning: " + itemName +
+                          " has only " + std::to_string(quantity) + " items left.";
+
+    // Insert into the Notifications table
+    CachedStatement stmt = conn.prepare("INSERT INTO Notifications (itemName, message) VALUES (?, ?) RETURNING id, timestamp");
+    if (!stmt) {
+        return false;
+    }
+    bindText(stmt, 1, itemName);
+    bindText(stmt, 2, message);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+    raised.push_back({sqlite3_column_int64(stmt, 0), itemName, message,
+                      reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))});
+    std::cout << "Notification saved: " << message << std::endl;
+    return true;
+}
+
+// Notifies items that fell below the threshold since the last pass and re-arms restocked ones.
+// The notifications written are appended to `raised`; false on error.
+inline bool evaluateLowStock(DbConnection& conn, std::vector<Notification>& raised) {
+    struct LowItem {
+        long long id;
+        std::string itemName;
+        long long quantity;
+    };
+    std::vector<LowItem> items;
+    {
+        CachedStatement stmt = conn.prepare("SELECT id, itemName, quantity FROM Inventory WHERE lowStockNotified = 0 AND quantity < ?");
+        if (!stmt) {
+            return false;
+        }
+        sqlite3_bind_int(stmt, 1, kLowStockThreshold);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            items.push_back({sqlite3_column_int64(stmt, 0),
+                             reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                             sqlite3_column_int64(stmt, 2)});
+        }
+    }
+
+    for (const LowItem& item : items) {
+        if (!checkAndNotifyLowStock(item.itemName, item.quantity, conn, raised)) {
+            return false;
+        }
+        CachedStatement stmt = conn.prepare("UPDATE Inventory SET lowStockNotified = 1 WHERE id = ?");
+        if (!stmt) {
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, item.id);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            return false;
+        }
+    }
+
+    CachedStatement stmt = conn.prepare("UPDATE Inventory SET lowStockNotified = 0 WHERE lowStockNotified = 1 AND quantity >= ?");
+    if (!stmt) {
+        return false;
+    }
+    sqlite3_bind_int(stmt, 1, kLowStockThreshold);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        return false;
+    }
+    return true;
+}
+
+// Runs evaluateLowStock() on the write queue whenever the Inventory table has changed,
+// checking at most once per interval, and publishes the committed notifications to the feed.
+// Bursts of dispensing therefore cost one pass (and at most one notification per item)
+// instead of a notification insert per update.
+class LowStockEvaluator {
+public:
+    LowStockEvaluator(WriteQueue& queue, const TableVersions& versions, NotificationFeed& feed,
+                      std::chrono::milliseconds interval)
+        : queue_(queue), versions_(versions), feed_(feed), interval_(interval), thread_([this] { run(); }) {}
+
+    LowStockEvaluator(const LowStockEvaluator&) = delete;
+    LowStockEvaluator& operator=(const LowStockEvaluator&) = delete;
+
+    ~LowStockEvaluator() { stop(); }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    void run() {
+        // Evaluate once at startup: stock may have changed while the server was down
+        uint64_t evaluated = UINT64_MAX;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, interval_, [this] { return stopping_; })) {
+            uint64_t version = versions_.get("Inventory");
+            if (version == evaluated) {
+                continue;
+            }
+            lock.unlock();
+            std::vector<Notification> raised;
+            bool committed = queue_.submit([&raised](DbConnection& conn) {
+                raised.clear();
+                return evaluateLowStock(conn, raised);
+            }).get();
+            if (!committed) {
+                std::cerr << "Low-stock evaluation failed; will retry" << std::endl;
+            } else {
+                feed_.publish(raised);
+                // Our own flag updates bump the version once more; the next pass finds nothing to do
+                evaluated = version;
+            }
+            lock.lock();
+        }
+    }
+
+    WriteQueue& queue_;
+    const TableVersions& versions_;
+    NotificationFeed& feed_;
+    std::chrono::milliseconds interval_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;  // last, so it starts after everything above is initialized
+};
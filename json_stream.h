@@ -0,0 +1,176 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ------------------ Byte Sinks ------------------
+
+// Destination for serialized output. Writers hand over bytes in buffer-sized chunks.
+class ByteSink {
+public:
+    virtual ~ByteSink() = default;
+    virtual void write(const char* data, size_t size) = 0;
+    // Called once after the last write
+    virtual void finish() {}
+};
+
+// Appends to a caller-owned string, typically crow::response::body
+class StringSink : public ByteSink {
+public:
+    explicit StringSink(std::string& out) : out_(out) {}
+    void write(const char* data, size_t size) override { out_.append(data, size); }
+
+private:
+    std::string& out_;
+};
+
+// ------------------ Streaming JSON Writer ------------------
+
+// Writes JSON token by token into a reusable buffer that is handed to the sink whenever it
+// fills up, so serializing a result set never builds an intermediate DOM. Commas between
+// members and elements are inserted automatically.
+class JsonStreamWriter {
+public:
+    explicit JsonStreamWriter(ByteSink& sink, size_t bufferSize = 64 * 1024)
+        : sink_(sink), bufferSize_(bufferSize) {
+        buffer_.reserve(bufferSize_ + 256);
+    }
+
+    JsonStreamWriter(const JsonStreamWriter&) = delete;
+    JsonStreamWriter& operator=(const JsonStreamWriter&) = delete;
+
+    void beginObject() { open('{'); }
+    void endObject() { close('}'); }
+    void beginArray() { open('['); }
+    void endArray() { close(']'); }
+
+    void key(std::string_view name) {
+        separate();
+        writeString(name);
+        buffer_ += ':';
+        afterKey_ = true;
+    }
+
+    void value(std::string_view text) {
+        separate();
+        writeString(text);
+        maybeFlush();
+    }
+    void value(const char* text) {
+        if (text) {
+            value(std::string_view(text));
+        } else {
+            null();
+        }
+    }
+    void value(long long number) {
+        separate();
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        buffer_.append(digits, result.ptr);
+        maybeFlush();
+    }
+    void value(int number) { value(static_cast<long long>(number)); }
+    void value(double number) {
+        separate();
+        if (!std::isfinite(number)) {
+            buffer_ += "null";
+        } else {
+            char digits[32];
+            auto result = std::to_chars(digits, digits + sizeof(digits), number);
+            buffer_.append(digits, result.ptr);
+        }
+        maybeFlush();
+    }
+    void value(bool flag) {
+        separate();
+        buffer_ += flag ? "true" : "false";
+    }
+    void null() {
+        separate();
+        buffer_ += "null";
+    }
+
+    // Hands any buffered bytes to the sink
+    void flush() {
+        if (!buffer_.empty()) {
+            sink_.write(buffer_.data(), buffer_.size());
+            buffer_.clear();
+        }
+    }
+
+    // Flushes and signals the end of the document to the sink
+    void finish() {
+        flush();
+        sink_.finish();
+    }
+
+private:
+    void open(char bracket) {
+        separate();
+        buffer_ += bracket;
+        first_.push_back(true);
+    }
+
+    void close(char bracket) {
+        buffer_ += bracket;
+        first_.pop_back();
+        maybeFlush();
+    }
+
+    void separate() {
+        if (afterKey_) {
+            afterKey_ = false;
+            return;
+        }
+        if (!first_.empty()) {
+            if (first_.back()) {
+                first_.back() = false;
+            } else {
+                buffer_ += ',';
+            }
+        }
+    }
+
+    void writeString(std::string_view text) {
+        static const char hex[] = "0123456789abcdef";
+        buffer_ += '"';
+        size_t runStart = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            buffer_.append(text.data() + runStart, i - runStart);
+            runStart = i + 1;
+            switch (c) {
+                case '"': buffer_ += "\\\""; break;
+                case '\\': buffer_ += "\\\\"; break;
+                case '\n': buffer_ += "\\n"; break;
+                case '\r': buffer_ += "\\r"; break;
+                case '\t': buffer_ += "\\t"; break;
+                default:
+                    buffer_ += "\\u00";
+                    buffer_ += hex[c >> 4];
+                    buffer_ += hex[c & 0xF];
+            }
+        }
+        buffer_.append(text.data() + runStart, text.size() - runStart);
+        buffer_ += '"';
+    }
+
+    void maybeFlush() {
+        if (buffer_.size() >= bufferSize_) {
+            flush();
+        }
+    }
+
+    ByteSink& sink_;
+    size_t bufferSize_;
+    std::string buffer_;
+    std::vector<bool> first_;
+    bool afterKey_ = false;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// ------------------ Latency Histogram ------------------
+// HDR-style log-linear buckets: exact below 32, then 32 sub-buckets per power of two, so
+// every recorded value is kept to within ~3% across the whole range. Recording is a single
+// relaxed atomic increment; readers take an unsynchronized snapshot.
+
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+    static constexpr int kMaxBits = 40;  // values clamp to 2^40 - 1 (about 12 days in microseconds)
+    static constexpr size_t kBucketCount = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+    void record(uint64_t value) {
+        buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    struct Snapshot {
+        std::array<uint64_t, kBucketCount> counts;
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        // Highest value equivalent to the q-th quantile (0 when empty)
+        uint64_t quantile(double q) const {
+            if (count == 0) {
+                return 0;
+            }
+            uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count) + 0.999999);
+            rank = rank == 0 ? 1 : rank;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBucketCount; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    return bucketUpperBound(i);
+                }
+            }
+            return bucketUpperBound(kBucketCount - 1);
+        }
+    };
+
+    Snapshot snapshot() const {
+        Snapshot snap;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            snap.counts[i] = buckets_[i].load(std::memory_order_relaxed);
+            snap.count += snap.counts[i];
+        }
+        snap.sum = sum_.load(std::memory_order_relaxed);
+        return snap;
+    }
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        if (value >> kMaxBits) {
+            value = (uint64_t(1) << kMaxBits) - 1;
+        }
+        int magnitude = 63 - __builtin_clzll(value);  // value lies in [2^magnitude, 2^(magnitude+1))
+        int shift = magnitude - kSubBucketBits;
+        return static_cast<size_t>(shift) * kSubBuckets + static_cast<size_t>(value >> shift);
+    }
+
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < 2 * kSubBuckets) {
+            return index;
+        }
+        int shift = static_cast<int>(index / kSubBuckets) - 1;
+        uint64_t subBucket = index % kSubBuckets + kSubBuckets;
+        return ((subBucket + 1) << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    std::atomic<uint64_t> sum_{0};
+};
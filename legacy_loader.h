@@ -0,0 +1,325 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "records.h"
+
+// ------------------ Legacy Data Loader ------------------
+// Reads the original pretty-printed data files (one JSON array of records each) without
+// building a DOM: the file is memory-mapped and fed to nlohmann's SAX parser, whose events
+// are written straight into the record structs. Values are moved in, not copied, and the
+// output vector is reserved up front. loadLegacyData() reads all six files in parallel.
+
+// Read-only mapping of a whole file; empty if it is missing or cannot be mapped
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = static_cast<const char*>(data);
+                size_ = static_cast<size_t>(st.st_size);
+                ::madvise(data, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// One JSON member of a record and the struct field it fills; exactly one pointer is set
+template <typename T>
+struct LegacyField {
+    const char* name;
+    int T::*intField = nullptr;
+    double T::*doubleField = nullptr;
+    bool T::*boolField = nullptr;
+    std::string T::*stringField = nullptr;
+};
+
+template <typename T>
+LegacyField<T> intField(const char* name, int T::*field) {
+    LegacyField<T> f{name};
+    f.intField = field;
+    return f;
+}
+template <typename T>
+LegacyField<T> doubleField(const char* name, double T::*field) {
+    LegacyField<T> f{name};
+    f.doubleField = field;
+    return f;
+}
+template <typename T>
+LegacyField<T> boolField(const char* name, bool T::*field) {
+    LegacyField<T> f{name};
+    f.boolField = field;
+    return f;
+}
+template <typename T>
+LegacyField<T> stringField(const char* name, std::string T::*field) {
+    LegacyField<T> f{name};
+    f.stringField = field;
+    return f;
+}
+
+// Field tables, matching the keys written by to_json() in records.h
+template <typename T>
+const std::vector<LegacyField<T>>& legacyFields();
+
+template <>
+inline const std::vector<LegacyField<Patient>>& legacyFields<Patient>() {
+    static const std::vector<LegacyField<Patient>> fields = {
+        intField("id", &Patient::id), stringField("name", &Patient::name),
+        stringField("address", &Patient::address), stringField("medicalHistory", &Patient::medicalHistory),
+        boolField("hasInsurance", &Patient::hasInsurance), stringField("insuranceCompany", &Patient::insuranceCompany)};
+    return fields;
+}
+
+template <>
+inline const std::vector<LegacyField<Doctor>>& legacyFields<Doctor>() {
+    static const std::vector<LegacyField<Doctor>> fields = {
+        intField("id", &Doctor::id), stringField("name", &Doctor::name),
+        stringField("specialty", &Doctor::specialty), stringField("contactInfo", &Doctor::contactInfo)};
+    return fields;
+}
+
+template <>
+inline const std::vector<LegacyField<Appointment>>& legacyFields<Appointment>() {
+    static const std::vector<LegacyField<Appointment>> fields = {
+        intField("patientId", &Appointment::patientId), intField("doctorId", &Appointment::doctorId),
+        stringField("date", &Appointment::date), stringField("time", &Appointment::time)};
+    return fields;
+}
+
+template <>
+inline const std::vector<LegacyField<MedicalRecord>>& legacyFields<MedicalRecord>() {
+    static const std::vector<LegacyField<MedicalRecord>> fields = {
+        intField("recordId", &MedicalRecord::recordId), intField("patientId", &MedicalRecord::patientId),
+        stringField("visitDate", &MedicalRecord::visitDate), stringField("notes", &MedicalRecord::notes),
+        stringField("diagnosis", &MedicalRecord::diagnosis)};
+    return fields;
+}
+
+template <>
+inline const std::vector<LegacyField<Prescription>>& legacyFields<Prescription>() {
+    static const std::vector<LegacyField<Prescription>> fields = {
+        intField("prescriptionId", &Prescription::prescriptionId), intField("patientId", &Prescription::patientId),
+        intField("doctorId", &Prescription::doctorId), stringField("medication", &Prescription::medication),
+        stringField("dosage", &Prescription::dosage), stringField("instructions", &Prescription::instructions),
+        stringField("datePrescribed", &Prescription::datePrescribed)};
+    return fields;
+}
+
+template <>
+inline const std::vector<LegacyField<Bill>>& legacyFields<Bill>() {
+    static const std::vector<LegacyField<Bill>> fields = {
+        intField("billId", &Bill::billId), intField("patientId", &Bill::patientId),
+        intField("appointmentId", &Bill::appointmentId), doubleField("medicationFee", &Bill::medicationFee),
+        doubleField("consultationFee", &Bill::consultationFee), doubleField("surgeryFee", &Bill::surgeryFee),
+        doubleField("totalFee", &Bill::totalFee), boolField("isInsured", &Bill::isInsured),
+        boolField("claimed", &Bill::claimed), stringField("insuranceCompany", &Bill::insuranceCompany),
+        stringField("claimStatus", &Bill::claimStatus)};
+    return fields;
+}
+
+// SAX handler for `[ {record}, {record}, ... ]`. A record is kept only if every field in its
+// table was present with a usable type, like the original contains()/get<>() loaders.
+template <typename T>
+class LegacyRecordHandler : public nlohmann::json_sax<nlohmann::json> {
+public:
+    explicit LegacyRecordHandler(std::vector<T>& out)
+        : out_(out), fields_(legacyFields<T>()), allFields_((uint64_t{1} << fields_.size()) - 1) {}
+
+    bool null() override { return skipValue(); }
+    bool boolean(bool val) override {
+        const LegacyField<T>* f = currentField();
+        if (f && f->boolField) {
+            current_.*(f->boolField) = val;
+            return markSeen();
+        }
+        return skipValue();
+    }
+    bool number_integer(number_integer_t val) override { return number(static_cast<double>(val), val); }
+    bool number_unsigned(number_unsigned_t val) override {
+        return number(static_cast<double>(val), static_cast<long long>(val));
+    }
+    bool number_float(number_float_t val, const string_t&) override {
+        return number(val, static_cast<long long>(val));
+    }
+    bool string(string_t& val) override {
+        const LegacyField<T>* f = currentField();
+        if (f && f->stringField) {
+            current_.*(f->stringField) = std::move(val);
+            return markSeen();
+        }
+        return skipValue();
+    }
+    bool binary(binary_t&) override { return skipValue(); }
+
+    bool start_object(std::size_t) override {
+        if (++depth_ == 2) {
+            current_ = T();
+            seen_ = 0;
+        }
+        fieldIndex_ = -1;
+        return true;
+    }
+    bool key(string_t& val) override {
+        fieldIndex_ = -1;
+        if (depth_ == 2) {
+            for (size_t i = 0; i < fields_.size(); ++i) {
+                if (val == fields_[i].name) {
+                    fieldIndex_ = static_cast<int>(i);
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+    bool end_object() override {
+        if (depth_-- == 2 && seen_ == allFields_) {
+            out_.push_back(std::move(current_));
+        }
+        fieldIndex_ = -1;
+        return true;
+    }
+    bool start_array(std::size_t) override {
+        ++depth_;
+        fieldIndex_ = -1;
+        return true;
+    }
+    bool end_array() override {
+        --depth_;
+        return true;
+    }
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        error_ = "at byte " + std::to_string(position) + ": " + ex.what();
+        return false;
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    const LegacyField<T>* currentField() const {
+        return depth_ == 2 && fieldIndex_ >= 0 ? &fields_[static_cast<size_t>(fieldIndex_)] : nullptr;
+    }
+
+    bool number(double asDouble, long long asInteger) {
+        const LegacyField<T>* f = currentField();
+        if (f && f->intField) {
+            current_.*(f->intField) = static_cast<int>(asInteger);
+            return markSeen();
+        }
+        if (f && f->doubleField) {
+            current_.*(f->doubleField) = asDouble;
+            return markSeen();
+        }
+        return skipValue();
+    }
+
+    bool markSeen() {
+        seen_ |= uint64_t{1} << fieldIndex_;
+        fieldIndex_ = -1;
+        return true;
+    }
+
+    bool skipValue() {
+        fieldIndex_ = -1;
+        return true;
+    }
+
+    std::vector<T>& out_;
+    const std::vector<LegacyField<T>>& fields_;
+    const uint64_t allFields_;
+    T current_{};
+    uint64_t seen_ = 0;
+    int depth_ = 0;
+    int fieldIndex_ = -1;
+    std::string error_;
+};
+
+// Loads one legacy data file; a missing file yields no records, a malformed one the records
+// parsed before the error
+template <typename T>
+std::vector<T> loadLegacyRecords(const std::string& path) {
+    std::vector<T> records;
+    MappedFile file(path);
+    if (file.empty()) {
+        return records;
+    }
+
+    // Every record closes with '}', so this count is a tight upper bound for reserve()
+    size_t closingBraces = 0;
+    for (const char* p = file.data(); (p = static_cast<const char*>(
+             std::memchr(p, '}', file.size() - static_cast<size_t>(p - file.data())))) != nullptr;
+         ++p) {
+        ++closingBraces;
+    }
+    records.reserve(closingBraces);
+
+    LegacyRecordHandler<T> handler(records);
+    if (!nlohmann::json::sax_parse(file.data(), file.data() + file.size(), &handler)) {
+        std::cerr << "Legacy data file " << path << " is malformed " << handler.error() << std::endl;
+    }
+    records.shrink_to_fit();
+    return records;
+}
+
+struct LegacyData {
+    std::vector<Patient> patients;
+    std::vector<Doctor> doctors;
+    std::vector<Appointment> appointments;
+    std::vector<MedicalRecord> medicalRecords;
+    std::vector<Prescription> prescriptions;
+    std::vector<Bill> bills;
+};
+
+// Reads the six legacy files from `dir`, one thread per file
+inline LegacyData loadLegacyData(const std::string& dir) {
+    std::string prefix = dir.empty() ? "" : dir + "/";
+    auto patients = std::async(std::launch::async, loadLegacyRecords<Patient>, prefix + "patients.json");
+    auto doctors = std::async(std::launch::async, loadLegacyRecords<Doctor>, prefix + "doctors.json");
+    auto appointments = std::async(std::launch::async, loadLegacyRecords<Appointment>, prefix + "appointments.json");
+    auto medicalRecords = std::async(std::launch::async, loadLegacyRecords<MedicalRecord>, prefix + "medical_records.json");
+    auto prescriptions = std::async(std::launch::async, loadLegacyRecords<Prescription>, prefix + "prescriptions.json");
+    auto bills = std::async(std::launch::async, loadLegacyRecords<Bill>, prefix + "bills.json");
+
+    LegacyData data;
+    data.patients = patients.get();
+    data.doctors = doctors.get();
+    data.appointments = appointments.get();
+    data.medicalRecords = medicalRecords.get();
+    data.prescriptions = prescriptions.get();
+    data.bills = bills.get();
+    return data;
+}
@@ -0,0 +1,298 @@
+#pragma once
+#include "crow.h"
+#include <sqlite3.h>
+#include <optional>
+#include <string>
+#include <vector>
+#include "database.h"
+#include "json_stream.h"
+#include "response_format.h"
+#include "validation.h"
+
+// ------------------ Keyset Pagination ------------------
+// List endpoints return at most `limit` rows with id > `after_id`, ordered by id, plus a
+// `nextCursor` to pass as the next `after_id`. Each page is an index range seek, so cost
+// stays bounded no matter how large the table grows.
+
+enum class ColumnType { Integer, Real, Text };
+
+struct ListColumn {
+    const char* name;
+    ColumnType type;
+};
+
+// Optional `?param=value` equality filter on a column
+struct ListFilter {
+    const char* param;
+    const char* column;
+    ColumnType type;
+};
+
+struct ListSpec {
+    const char* table;
+    const char* responseKey;          // JSON array name, e.g. "patients"
+    std::vector<ListColumn> columns;  // the first column is the integer primary key
+    std::vector<ListFilter> filters;
+};
+
+constexpr long long kDefaultPageSize = 100;
+constexpr long long kMaxPageSize = 1000;
+
+struct PageRequest {
+    long long limit = kDefaultPageSize;
+    long long afterId = 0;
+};
+
+inline bool parsePageRequest(const crow::query_string& qs, PageRequest& page, std::string& error) {
+    if (const char* limit = qs.get("limit")) {
+        if (!parseInt64Param(limit, page.limit) || page.limit < 1 || page.limit > kMaxPageSize) {
+            error = "Invalid 'limit': expected 1-" + std::to_string(kMaxPageSize);
+            return false;
+        }
+    }
+    if (const char* afterId = qs.get("after_id")) {
+        if (!parseInt64Param(afterId, page.afterId) || page.afterId < 0) {
+            error = "Invalid 'after_id': expected a non-negative id";
+            return false;
+        }
+    }
+    return true;
+}
+
+// SELECT <columns> FROM <table> WHERE id > ? [AND <filter> = ?]... ORDER BY id LIMIT ?
+// Only the filters present in the request appear in the SQL, so each combination maps to
+// one cached statement.
+inline std::string buildListSql(const ListSpec& spec, const std::vector<const ListFilter*>& active) {
+    const char* idColumn = spec.columns.front().name;
+    std::string sql = "SELECT ";
+    for (size_t i = 0; i < spec.columns.size(); ++i) {
+        sql += (i ? ", " : "");
+        sql += spec.columns[i].name;
+    }
+    sql += " FROM ";
+    sql += spec.table;
+    sql += " WHERE ";
+    sql += idColumn;
+    sql += " > ?";
+    for (const ListFilter* filter : active) {
+        sql += " AND ";
+        sql += filter->column;
+        sql += " = ?";
+    }
+    sql += " ORDER BY ";
+    sql += idColumn;
+    sql += " LIMIT ?";
+    return sql;
+}
+
+// Writes the statement's current row as one object keyed by column name, with any of the
+// stream writers (JSON, CBOR, MessagePack)
+template <typename Writer>
+void writeRowObject(Writer& writer, sqlite3_stmt* stmt, const std::vector<ListColumn>& columns) {
+    writer.beginObject();
+    for (size_t c = 0; c < columns.size(); ++c) {
+        const ListColumn& column = columns[c];
+        int col = static_cast<int>(c);
+        writer.key(column.name);
+        if (sqlite3_column_type(stmt, col) == SQLITE_NULL) {
+            writer.null();
+        } else if (column.type == ColumnType::Integer) {
+            writer.value(static_cast<long long>(sqlite3_column_int64(stmt, col)));
+        } else if (column.type == ColumnType::Real) {
+            writer.value(sqlite3_column_double(stmt, col));
+        } else {
+            const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+            writer.value(std::string_view(text, sqlite3_column_bytes(stmt, col)));
+        }
+    }
+    writer.endObject();
+}
+
+inline crow::response listPage(DbConnection& conn, const ListSpec& spec, const crow::query_string& qs,
+                               BodyFormat format = BodyFormat::Json) {
+    PageRequest page;
+    std::string error;
+    if (!parsePageRequest(qs, page, error)) {
+        return crow::response(400, error);
+    }
+
+    std::vector<const ListFilter*> active;
+    std::vector<const char*> values;
+    for (const ListFilter& filter : spec.filters) {
+        if (const char* value = qs.get(filter.param)) {
+            active.push_back(&filter);
+            values.push_back(value);
+        }
+    }
+
+    CachedStatement stmt = conn.prepare(buildListSql(spec, active));
+    if (!stmt) {
+        return crow::response(500, "Failed to prepare statement");
+    }
+
+    int index = 1;
+    sqlite3_bind_int64(stmt, index++, page.afterId);
+    for (size_t i = 0; i < active.size(); ++i) {
+        const ListFilter& filter = *active[i];
+        if (filter.type == ColumnType::Integer) {
+            long long number;
+            if (!parseInt64Param(values[i], number)) {
+                return crow::response(400, std::string("Invalid '") + filter.param + "': expected an integer");
+            }
+            sqlite3_bind_int64(stmt, index++, number);
+        } else if (filter.type == ColumnType::Real) {
+            double number;
+            if (!parseDoubleParam(values[i], number)) {
+                return crow::response(400, std::string("Invalid '") + filter.param + "': expected a number");
+            }
+            sqlite3_bind_double(stmt, index++, number);
+        } else {
+            sqlite3_bind_text(stmt, index++, values[i], -1, SQLITE_STATIC);
+        }
+    }
+    // One extra row tells us whether another page exists
+    sqlite3_bind_int64(stmt, index, page.limit + 1);
+
+    return formatResponse(format, [&](auto& writer) -> std::optional<crow::response> {
+        writer.beginObject();
+        writer.key(spec.responseKey);
+        writer.beginArray();
+
+        long long rowCount = 0;
+        long long lastId = 0;
+        bool hasMore = false;
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            if (rowCount == page.limit) {
+                hasMore = true;
+                break;
+            }
+            writeRowObject(writer, stmt, spec.columns);
+            lastId = sqlite3_column_int64(stmt, 0);
+            ++rowCount;
+        }
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+            return crow::response(500, "Failed to read rows");
+        }
+
+        writer.endArray();
+        writer.key("nextCursor");
+        if (hasMore) {
+            writer.value(lastId);
+        } else {
+            writer.null();
+        }
+        writer.endObject();
+        return std::nullopt;
+    });
+}
+
+// Full export of a table as {"<responseKey>": [...]}. Rows are serialized straight from the
+// statement into the response body as they are stepped; no per-row objects are built. With an
+// `encoding` the body is compressed as it is serialized, so the uncompressed export is never
+// held in memory.
+inline crow::response exportTable(DbConnection& conn, const ListSpec& spec, BodyFormat format = BodyFormat::Json,
+                                  ContentEncoding encoding = ContentEncoding::Identity) {
+    std::string sql = "SELECT ";
+    for (size_t i = 0; i < spec.columns.size(); ++i) {
+        sql += (i ? ", " : "");
+        sql += spec.columns[i].name;
+    }
+    sql += std::string(" FROM ") + spec.table + " ORDER BY " + spec.columns.front().name;
+
+    CachedStatement stmt = conn.prepare(sql);
+    if (!stmt) {
+        return crow::response(500, "Failed to prepare statement");
+    }
+
+    return formatResponse(format, [&](auto& writer) -> std::optional<crow::response> {
+        writer.beginObject();
+        writer.key(spec.responseKey);
+        writer.beginArray();
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            writeRowObject(writer, stmt, spec.columns);
+        }
+        if (rc != SQLITE_DONE) {
+            return crow::response(500, "Failed to read rows");
+        }
+        writer.endArray();
+        writer.endObject();
+        return std::nullopt;
+    }, encoding);
+}
+
+// ------------------ List Endpoint Specs ------------------
+
+inline const ListSpec& patientListSpec() {
+    static const ListSpec spec{
+        "Patients", "patients",
+        {{"id", ColumnType::Integer}, {"name", ColumnType::Text}, {"address", ColumnType::Text},
+         {"medicalHistory", ColumnType::Text}, {"hasInsurance", ColumnType::Integer},
+         {"insuranceCompany", ColumnType::Text}},
+        {{"hasInsurance", "hasInsurance", ColumnType::Integer},
+         {"insuranceCompany", "insuranceCompany", ColumnType::Text}}};
+    return spec;
+}
+
+inline const ListSpec& appointmentListSpec() {
+    static const ListSpec spec{
+        "Appointments", "appointments",
+        {{"id", ColumnType::Integer}, {"patientId", ColumnType::Integer}, {"doctorId", ColumnType::Integer},
+         {"date", ColumnType::Text}, {"time", ColumnType::Text}},
+        {{"doctorId", "doctorId", ColumnType::Integer},
+         {"date", "date", ColumnType::Text},
+         {"patientId", "patientId", ColumnType::Integer}}};
+    return spec;
+}
+
+inline const ListSpec& doctorListSpec() {
+    static const ListSpec spec{
+        "Doctors", "doctors",
+        {{"id", ColumnType::Integer}, {"name", ColumnType::Text}, {"specialty", ColumnType::Text},
+         {"contactInfo", ColumnType::Text}},
+        {{"specialty", "specialty", ColumnType::Text}}};
+    return spec;
+}
+
+inline const ListSpec& billListSpec() {
+    static const ListSpec spec{
+        "Bills", "bills",
+        {{"id", ColumnType::Integer}, {"patientId", ColumnType::Integer}, {"appointmentId", ColumnType::Integer},
+         {"medicationFee", ColumnType::Real}, {"consultationFee", ColumnType::Real},
+         {"surgeryFee", ColumnType::Real}, {"totalFee", ColumnType::Real},
+         {"isInsured", ColumnType::Integer}, {"claimed", ColumnType::Integer},
+         {"insuranceCompany", ColumnType::Text}, {"claimStatus", ColumnType::Text}},
+        {{"claimStatus", "claimStatus", ColumnType::Text},
+         {"patientId", "patientId", ColumnType::Integer},
+         {"insuranceCompany", "insuranceCompany", ColumnType::Text}}};
+    return spec;
+}
+
+inline const ListSpec& inventoryListSpec() {
+    static const ListSpec spec{
+        "Inventory", "inventory",
+        {{"id", ColumnType::Integer}, {"itemName", ColumnType::Text}, {"quantity", ColumnType::Integer}},
+        {{"itemName", "itemName", ColumnType::Text}}};
+    return spec;
+}
+
+inline const ListSpec& notificationListSpec() {
+    static const ListSpec spec{
+        "Notifications", "notifications",
+        {{"id", ColumnType::Integer}, {"itemName", ColumnType::Text}, {"message", ColumnType::Text},
+         {"timestamp", ColumnType::Text}},
+        {}};
+    return spec;
+}
+
+// Spec for a table exposed under /export/<name>, or nullptr
+inline const ListSpec* listSpecByName(const std::string& name) {
+    if (name == "patients") return &patientListSpec();
+    if (name == "appointments") return &appointmentListSpec();
+    if (name == "doctors") return &doctorListSpec();
+    if (name == "bills") return &billListSpec();
+    if (name == "inventory") return &inventoryListSpec();
+    if (name == "notifications") return &notificationListSpec();
+    return nullptr;
+}
@@ -2,448 +2,1173 @@
 #include <sqlite3.h>
 #include <vector>
 #include <string>
-#include <regex>
-#include <mutex>
-#include <sstream>
 #include <exception>
 #include <iostream>
 #include <fstream>
 #include <algorithm> // std::find_if
+#include <limits>
 #include <nlohmann/json.hpp>
-using json = nlohmann::json;
+#include "database.h"
+#include "legacy_loader.h"
+#include "query_plans.h"
+#include "validation.h"
+#include "list_query.h"
+#include "schedule_index.h"
+#include "entity_cache.h"
+#include "request_body.h"
+#include "write_queue.h"
+#include "response_cache.h"
+#include "json_stream.h"
+#include "notification_feed.h"
+#include "inventory.h"
+#include "metrics.h"
+#include "claims.h"
+#include "billing_analytics.h"
+#include "search.h"
+#include "timeline.h"
+#include "response_format.h"
+#include "compression.h"
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+
+//Global Data
+ScheduleIndex doctorSchedule;  // booked slots per doctor per day, mirrors the Appointments table
+// Rows by id for foreign-key checks; nullopt remembers that the id does not exist
+constexpr size_t kEntityCacheCapacity = 100000;
+ShardedLruCache<long long, std::optional<Patient>> patientCache(kEntityCacheCapacity);
+ShardedLruCache<long long, std::optional<Doctor>> doctorCache(kEntityCacheCapacity);
 
+// ------------------ Utility Functions ------------------
+// Date, time and number parsing lives in validation.h
 
+// Column text, or "" for NULL
+std::string columnText(sqlite3_stmt* stmt, int col) {
+    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+    return text ? std::string(text, sqlite3_column_bytes(stmt, col)) : std::string();
+}
 
-sqlite3* initDatabase(const std::string& dbPath, const std::string& schemaPath) {
-    sqlite3* db;
+// Patient by id through the cache; throws if the lookup itself fails
+std::optional<Patient> findPatient(DbConnection& conn, long long id) {
+    return patientCache.getOrLoad(id, [&]() -> std::optional<Patient> {
+        CachedStatement stmt = conn.prepare("SELECT id, name, address, medicalHistory, hasInsurance, insuranceCompany FROM Patients WHERE id = ?");
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare patient lookup");
+        }
+        sqlite3_bind_int64(stmt, 1, id);
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_DONE) {
+            return std::nullopt;
+        }
+        if (rc != SQLITE_ROW) {
+            throw std::runtime_error("Failed to read patient");
+        }
+        // Read inside a write transaction: forget it again if that transaction rolls back
+        conn.onRollback([id] { patientCache.erase(id); });
+        return Patient{sqlite3_column_int(stmt, 0), columnText(stmt, 1), columnText(stmt, 2),
+                       columnText(stmt, 3), sqlite3_column_int(stmt, 4) != 0, columnText(stmt, 5)};
+    });
+}
 
-    // Open the SQLite database
-    if (sqlite3_open(dbPath.c_str(), &db)) {
-        throw std::runtime_error("Cannot open database: " + std::string(sqlite3_errmsg(db)));
+// Doctor by id through the cache; throws if the lookup itself fails
+std::optional<Doctor> findDoctor(DbConnection& conn, long long id) {
+    return doctorCache.getOrLoad(id, [&]() -> std::optional<Doctor> {
+        CachedStatement stmt = conn.prepare("SELECT id, name, specialty, contactInfo FROM Doctors WHERE id = ?");
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare doctor lookup");
+        }
+        sqlite3_bind_int64(stmt, 1, id);
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_DONE) {
+            return std::nullopt;
+        }
+        if (rc != SQLITE_ROW) {
+            throw std::runtime_error("Failed to read doctor");
+        }
+        conn.onRollback([id] { doctorCache.erase(id); });
+        return Doctor{sqlite3_column_int(stmt, 0), columnText(stmt, 1), columnText(stmt, 2), columnText(stmt, 3)};
+    });
+}
+
+// ------------------ Record Writers ------------------
+// Shared by the single-record routes and the batch endpoints. Text fields are bound without copying.
+
+struct WriteResult {
+    int status = 200;   // HTTP status for this record
+    std::string error;
+    long long id = 0;
+    long long billId = 0;  // bookings only
+};
+
+WriteResult writeFailure(int status, std::string error) {
+    WriteResult result;
+    result.status = status;
+    result.error = std::move(error);
+    return result;
+}
+
+struct PatientInput {
+    std::string_view name;
+    std::string_view address;
+    std::string_view medicalHistory;
+    std::optional<std::string_view> insuranceCompany;  // present means the patient is insured
+};
+
+struct DoctorInput {
+    std::string_view name;
+    std::string_view specialty;
+    std::string_view contactInfo;
+};
+
+struct AppointmentInput {
+    long long patientId = 0;
+    long long doctorId = 0;
+    std::string_view date;
+    std::string_view time;
+};
+
+struct PrescriptionInput {
+    long long patientId = 0;
+    long long doctorId = 0;
+    std::string_view medication;
+    std::string_view dosage;
+    std::string_view instructions;
+    std::string_view datePrescribed;
+};
+
+struct MedicalRecordInput {
+    long long patientId = 0;
+    std::string_view visitDate;
+    std::string_view notes;
+    std::string_view diagnosis;
+};
+
+WriteResult insertPatient(DbConnection& conn, const PatientInput& in) {
+    CachedStatement stmt = conn.prepare("INSERT INTO Patients (name, address, medicalHistory, hasInsurance, insuranceCompany) VALUES (?, ?, ?, ?, ?)");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare statement");
     }
+    bindText(stmt, 1, in.name);
+    bindText(stmt, 2, in.address);
+    bindText(stmt, 3, in.medicalHistory);
+    sqlite3_bind_int(stmt, 4, in.insuranceCompany ? 1 : 0);
+    bindText(stmt, 5, in.insuranceCompany.value_or(""));
 
-    // Load the schema file
-    std::ifstream schemaFile(schemaPath);
-    if (!schemaFile.is_open()) {
-        sqlite3_close(db);
-        throw std::runtime_error("Cannot open schema file: " + schemaPath);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        return writeFailure(500, "Failed to execute statement");
     }
+    WriteResult result;
+    result.id = sqlite3_last_insert_rowid(conn.handle());
+    return result;
+}
 
-    std::stringstream buffer;
-    buffer << schemaFile.rdbuf();
-    std::string schema = buffer.str();
-    schemaFile.close();
+WriteResult insertDoctor(DbConnection& conn, const DoctorInput& in) {
+    CachedStatement stmt = conn.prepare("INSERT INTO Doctors (name, specialty, contactInfo) VALUES (?, ?, ?)");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare statement");
+    }
+    bindText(stmt, 1, in.name);
+    bindText(stmt, 2, in.specialty);
+    bindText(stmt, 3, in.contactInfo);
 
-    // Execute the schema to create tables
-    char* errMsg = nullptr;
-    if (sqlite3_exec(db, schema.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
-        std::string error = errMsg;
-        sqlite3_free(errMsg);
-        sqlite3_close(db);
-        throw std::runtime_error("Failed to execute schema: " + error);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        return writeFailure(500, "Failed to execute statement");
+    }
+    WriteResult result;
+    result.id = sqlite3_last_insert_rowid(conn.handle());
+    return result;
+}
+
+// Books the slot and creates its (zero-fee) bill in one transaction, or a savepoint when
+// called inside a batch. Slot conflicts are rejected from the schedule index before SQLite.
+WriteResult bookAppointment(DbConnection& conn, const AppointmentInput& in) {
+    if (!isValidDate(in.date)) {
+        return writeFailure(400, "Invalid date. Expected a calendar date as YYYY-MM-DD");
+    }
+    if (!isValidAppointmentTime(in.time)) {
+        return writeFailure(400, "Invalid time. Appointments are every 10 minutes from 09:00 to 17:00");
+    }
+    // The schedule index keys doctors by int; an id outside that range cannot name a doctor
+    if (in.doctorId < 1 || in.doctorId > std::numeric_limits<int>::max()) {
+        return writeFailure(400, "Invalid doctorId: expected a positive integer");
+    }
+    std::string date(in.date);
+    std::string time(in.time);
+    int doctorId = static_cast<int>(in.doctorId);
+
+    // Claim the slot in the in-memory schedule first so conflicts are rejected without touching SQLite
+    SlotReservation slot(doctorSchedule, doctorId, date, time);
+    if (!slot.reserved()) {
+        return writeFailure(409, "Appointment slot already taken");
+    }
+
+    // Appointment and bill commit together or not at all; the unique slot index on
+    // Appointments(doctorId, date, time) rejects double bookings inside the transaction
+    Transaction txn(conn);
+    if (!txn.ok()) {
+        return writeFailure(503, "Database busy, please retry");
+    }
+    // From here the reservation is undone by the transaction if it (or an enclosing one) rolls back
+    conn.onRollback([doctorId, date, time] { doctorSchedule.release(doctorId, date, time); });
+    slot.keep();
+
+    // Insert appointment
+    CachedStatement stmt = conn.prepare("INSERT INTO Appointments (patientId, doctorId, date, time) VALUES (?, ?, ?, ?)");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare appointment statement");
+    }
+    sqlite3_bind_int64(stmt, 1, in.patientId);
+    sqlite3_bind_int64(stmt, 2, in.doctorId);
+    bindText(stmt, 3, date);
+    bindText(stmt, 4, time);
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        if (isUniqueViolation(conn)) {
+            // The database already holds this slot; keep it marked in the index
+            txn.rollback();
+            doctorSchedule.tryReserve(doctorId, date, time);
+            return writeFailure(409, "Appointment slot already taken");
+        }
+        return writeFailure(500, "Failed to execute appointment statement");
+    }
+    WriteResult result;
+    result.id = sqlite3_last_insert_rowid(conn.handle());
+
+    // Insert bill
+    stmt = conn.prepare("INSERT INTO Bills (patientId, appointmentId, isInsured) VALUES (?, ?, ?)");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare bill statement");
     }
+    sqlite3_bind_int64(stmt, 1, in.patientId);
+    sqlite3_bind_int64(stmt, 2, result.id);
+    sqlite3_bind_int(stmt, 3, 0);  // Example: no insurance for simplicity
 
-    std::cout << "Database initialized successfully with schema." << std::endl;
-    return db;
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        return writeFailure(500, "Failed to execute bill statement");
+    }
+    result.billId = sqlite3_last_insert_rowid(conn.handle());
+
+    if (!txn.commit()) {
+        return writeFailure(500, "Failed to commit appointment");
+    }
+    return result;
 }
 
+WriteResult addPrescription(DbConnection& conn, const PrescriptionInput& in) {
+    // Validate patient and doctor, usually without touching SQLite
+    try {
+        if (!findPatient(conn, in.patientId)) {
+            return writeFailure(404, "Patient not found");
+        }
+        if (!findDoctor(conn, in.doctorId)) {
+            return writeFailure(404, "Doctor not found");
+        }
+    } catch (const std::exception& e) {
+        return writeFailure(500, e.what());
+    }
 
+    // Insert prescription
+    CachedStatement stmt = conn.prepare("INSERT INTO Prescriptions (patientId, doctorId, medication, dosage, instructions, datePrescribed) VALUES (?, ?, ?, ?, ?, ?)");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare prescription statement");
+    }
+    sqlite3_bind_int64(stmt, 1, in.patientId);
+    sqlite3_bind_int64(stmt, 2, in.doctorId);
+    bindText(stmt, 3, in.medication);
+    bindText(stmt, 4, in.dosage);
+    bindText(stmt, 5, in.instructions);
+    bindText(stmt, 6, in.datePrescribed);
 
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        return writeFailure(500, "Failed to execute prescription statement");
+    }
+    WriteResult result;
+    result.id = sqlite3_last_insert_rowid(conn.handle());
+    return result;
+}
 
-//Data Structures
-struct Patient {
-    int id;
-    std::string name;
-    std::string address;
-    std::string medicalHistory;
-    bool hasInsurance;
-    std::string insuranceCompany;
-};
+WriteResult addMedicalRecord(DbConnection& conn, const MedicalRecordInput& in) {
+    if (!isValidDate(in.visitDate)) {
+        return writeFailure(400, "Invalid visitDate. Expected a calendar date as YYYY-MM-DD");
+    }
+    try {
+        if (!findPatient(conn, in.patientId)) {
+            return writeFailure(404, "Patient not found");
+        }
+    } catch (const std::exception& e) {
+        return writeFailure(500, e.what());
+    }
 
-struct Doctor {
-    int id;
-    std::string name;
-    std::string specialty;
-    std::string contactInfo;
-};
+    CachedStatement stmt = conn.prepare("INSERT INTO MedicalRecords (patientId, visitDate, notes, diagnosis) VALUES (?, ?, ?, ?)");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare medical record statement");
+    }
+    sqlite3_bind_int64(stmt, 1, in.patientId);
+    bindText(stmt, 2, in.visitDate);
+    bindText(stmt, 3, in.notes);
+    bindText(stmt, 4, in.diagnosis);
 
-struct Appointment {
-    int patientId;
-    int doctorId;
-    std::string date;  // YYYY-MM-DD
-    std::string time;  // HH:MM
-};
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        return writeFailure(500, "Failed to execute medical record statement");
+    }
+    WriteResult result;
+    result.id = sqlite3_last_insert_rowid(conn.handle());
+    return result;
+}
 
-struct MedicalRecord {
-    int recordId;
-    int patientId;
-    std::string visitDate;  // YYYY-MM-DD
-    std::string notes;
-    std::string diagnosis;
-};
+// ------------------ Batch Parsing ------------------
+// Each parser fills the input struct from one JSON row, or returns an error message.
 
-struct Prescription {
-    int prescriptionId;
-    int patientId;
-    int doctorId;
-    std::string medication;
-    std::string dosage;
-    std::string instructions;
-    std::string datePrescribed; // YYYY-MM-DD
-};
+std::string parsePatientRow(const crow::json::rvalue& row, PatientInput& in) {
+    if (!getStringField(row, "name", in.name) || !getStringField(row, "address", in.address) ||
+        !getStringField(row, "medicalHistory", in.medicalHistory)) {
+        return "Missing required fields: name, address, medicalHistory";
+    }
+    std::string_view insuranceCompany;
+    if (getStringField(row, "insuranceCompany", insuranceCompany)) {
+        in.insuranceCompany = insuranceCompany;
+    }
+    return "";
+}
 
-struct Bill {
-    int billId;
-    int patientId;
-    int appointmentId;
-    double medicationFee;
-    double consultationFee;
-    double surgeryFee;
-    double totalFee;
-    bool isInsured;
-    bool claimed;
-    std::string insuranceCompany;
-    std::string claimStatus; // e.g. "Pending", "Approved", "Denied"
-};
+std::string parseDoctorRow(const crow::json::rvalue& row, DoctorInput& in) {
+    if (!getStringField(row, "name", in.name) || !getStringField(row, "specialty", in.specialty) ||
+        !getStringField(row, "contactInfo", in.contactInfo)) {
+        return "Missing required fields: name, specialty, contactInfo";
+    }
+    return "";
+}
+
+std::string parseAppointmentRow(const crow::json::rvalue& row, AppointmentInput& in) {
+    if (!getIntField(row, "patientId", in.patientId) || !getIntField(row, "doctorId", in.doctorId) ||
+        !getStringField(row, "date", in.date) || !getStringField(row, "time", in.time)) {
+        return "Missing required fields: patientId, doctorId, date, time";
+    }
+    if (!isValidDate(in.date)) {
+        return "Invalid date. Expected a calendar date as YYYY-MM-DD";
+    }
+    if (!isValidAppointmentTime(in.time)) {
+        return "Invalid time. Appointments are every 10 minutes from 09:00 to 17:00";
+    }
+    return "";
+}
 
-//Global Data and Mutex
-std::vector<Patient> patients;
-std::vector<Doctor> doctors;
-std::vector<Appointment> appointments;
-std::vector<MedicalRecord> medicalRecords;
-std::vector<Prescription> prescriptions;
-std::vector<Bill> bills;
-std::mutex dataMutex;
-
-//File Operations
-void saveToFile(const std::string& filename, const json& data) {
-    std::ofstream file(filename, std::ios::out | std::ios::trunc);
-    if (file.is_open()) {
-        file << data.dump(4);
-        file.close();
+std::string parsePrescriptionRow(const crow::json::rvalue& row, PrescriptionInput& in) {
+    if (!getIntField(row, "patientId", in.patientId) || !getIntField(row, "doctorId", in.doctorId) ||
+        !getStringField(row, "medication", in.medication) || !getStringField(row, "dosage", in.dosage) ||
+        !getStringField(row, "instructions", in.instructions) ||
+        !getStringField(row, "datePrescribed", in.datePrescribed)) {
+        return "Missing required fields: patientId, doctorId, medication, dosage, instructions, datePrescribed";
     }
+    return "";
 }
 
-void ensureFileExists(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::ofstream newFile(filename);
-        newFile << "[]" << std::endl;
-        newFile.close();
+std::string parseMedicalRecordRow(const crow::json::rvalue& row, MedicalRecordInput& in) {
+    if (!getIntField(row, "patientId", in.patientId) || !getStringField(row, "visitDate", in.visitDate) ||
+        !getStringField(row, "notes", in.notes) || !getStringField(row, "diagnosis", in.diagnosis)) {
+        return "Missing required fields: patientId, visitDate, notes, diagnosis";
     }
+    return "";
 }
 
-void loadFromFile(const std::string& filename, json& data) {
-    std::ifstream file(filename);
-    if (file.is_open()) {
-        file >> data;
-        file.close();
+// Claim rows carry just the bill: {"billId":1}
+std::string parseClaimRow(const crow::json::rvalue& row, long long& billId) {
+    if (!getIntField(row, "billId", billId)) {
+        return "Missing required field: billId";
     }
+    return "";
 }
 
-//Load / Save Functions 
-void savePatientsToFile() {
-    json arr = json::array();
-    for (auto& p : patients) {
-        arr.push_back({
-            {"id", p.id},
-            {"name", p.name},
-            {"address", p.address},
-            {"medicalHistory", p.medicalHistory},
-            {"hasInsurance", p.hasInsurance},
-            {"insuranceCompany", p.insuranceCompany}
-            });
-    }
-    saveToFile("patients.json", arr);
+WriteResult claimWriteResult(ClaimResult claim, long long billId) {
+    if (claim != ClaimResult::Ok) {
+        return writeFailure(claimResultStatus(claim), claimResultMessage(claim));
+    }
+    WriteResult result;
+    result.id = billId;
+    return result;
 }
 
-void loadPatientsFromFile() {
-    ensureFileExists("patients.json");
-    json arr;
-    loadFromFile("patients.json", arr);
+WriteResult submitClaimRow(DbConnection& conn, const long long& billId) {
+    return claimWriteResult(submitClaim(conn, billId), billId);
+}
 
-    for (auto& item : arr) {
-        if (!item.contains("id") || !item.contains("name") ||
-            !item.contains("address") || !item.contains("medicalHistory") ||
-            !item.contains("hasInsurance") || !item.contains("insuranceCompany")) {
-            continue;
-        }
-        Patient p;
-        p.id = item["id"].get<int>();
-        p.name = item["name"].get<std::string>();
-        p.address = item["address"].get<std::string>();
-        p.medicalHistory = item["medicalHistory"].get<std::string>();
-        p.hasInsurance = item["hasInsurance"].get<bool>();
-        p.insuranceCompany = item["insuranceCompany"].get<std::string>();
-        patients.push_back(p);
+WriteResult approveClaimRow(DbConnection& conn, const long long& billId) {
+    return claimWriteResult(decideClaim(conn, billId, ClaimDecision::Approved), billId);
+}
+
+// ------------------ Record Updates ------------------
+// PUT replaces every mutable field and PATCH only the fields present in the body. Both run one
+// cached UPDATE per table: an absent field binds NULL and COALESCE keeps the stored value.
+// Parsers take `replace` (PUT) and return an error message or "".
+
+// Binds an optional text field, NULL when absent
+inline void bindOptionalText(sqlite3_stmt* stmt, int index, const std::optional<std::string_view>& text) {
+    if (text) {
+        bindText(stmt, index, *text);
+    } else {
+        sqlite3_bind_null(stmt, index);
     }
 }
 
-void saveDoctorsToFile() {
-    json arr = json::array();
-    for (auto& d : doctors) {
-        arr.push_back({
-            {"id", d.id},
-            {"name", d.name},
-            {"specialty", d.specialty},
-            {"contactInfo", d.contactInfo}
-            });
-    }
-    saveToFile("doctors.json", arr);
+// Steps an UPDATE ... WHERE id = ?; 404 if no row has that id
+WriteResult stepUpdate(DbConnection& conn, sqlite3_stmt* stmt, long long id, const char* missing) {
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        return writeFailure(500, "Failed to execute update");
+    }
+    if (sqlite3_changes(conn.handle()) == 0) {
+        return writeFailure(404, missing);
+    }
+    WriteResult result;
+    result.id = id;
+    return result;
 }
 
-void loadDoctorsFromFile() {
-    ensureFileExists("doctors.json");
-    json arr;
-    loadFromFile("doctors.json", arr);
+struct PatientPatch {
+    std::optional<std::string_view> name;
+    std::optional<std::string_view> address;
+    std::optional<std::string_view> medicalHistory;
+    bool setInsurance = false;                          // insuranceCompany given (possibly null)
+    std::optional<std::string_view> insuranceCompany;  // present means the patient is insured
+};
 
-    for (auto& item : arr) {
-        if (!item.contains("id") || !item.contains("name") ||
-            !item.contains("specialty") || !item.contains("contactInfo")) {
-            continue;
+std::string parsePatientPatch(const crow::json::rvalue& body, PatientPatch& patch, bool replace) {
+    if (replace) {
+        PatientInput in;
+        std::string error = parsePatientRow(body, in);
+        if (!error.empty()) {
+            return error;
+        }
+        patch = {in.name, in.address, in.medicalHistory, true, in.insuranceCompany};
+        return "";
+    }
+    if (!getOptionalStringField(body, "name", patch.name) || !getOptionalStringField(body, "address", patch.address) ||
+        !getOptionalStringField(body, "medicalHistory", patch.medicalHistory)) {
+        return "name, address and medicalHistory must be strings";
+    }
+    if (body.has("insuranceCompany")) {
+        // null drops the insurance
+        patch.setInsurance = true;
+        if (body["insuranceCompany"].t() != crow::json::type::Null &&
+            !getOptionalStringField(body, "insuranceCompany", patch.insuranceCompany)) {
+            return "insuranceCompany must be a string or null";
         }
-        Doctor d;
-        d.id = item["id"].get<int>();
-        d.name = item["name"].get<std::string>();
-        d.specialty = item["specialty"].get<std::string>();
-        d.contactInfo = item["contactInfo"].get<std::string>();
-        doctors.push_back(d);
     }
+    if (!patch.name && !patch.address && !patch.medicalHistory && !patch.setInsurance) {
+        return "No fields to update: name, address, medicalHistory, insuranceCompany";
+    }
+    return "";
 }
 
-void saveAppointmentsToFile() {
-    json arr = json::array();
-    for (auto& a : appointments) {
-        arr.push_back({
-            {"patientId", a.patientId},
-            {"doctorId", a.doctorId},
-            {"date", a.date},
-            {"time", a.time}
-            });
-    }
-    saveToFile("appointments.json", arr);
+WriteResult updatePatient(DbConnection& conn, long long id, const PatientPatch& patch) {
+    CachedStatement stmt = conn.prepare(
+        "UPDATE Patients SET name = COALESCE(?1, name), address = COALESCE(?2, address), "
+        "medicalHistory = COALESCE(?3, medicalHistory), hasInsurance = COALESCE(?4, hasInsurance), "
+        "insuranceCompany = COALESCE(?5, insuranceCompany) WHERE id = ?6");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare statement");
+    }
+    bindOptionalText(stmt, 1, patch.name);
+    bindOptionalText(stmt, 2, patch.address);
+    bindOptionalText(stmt, 3, patch.medicalHistory);
+    if (patch.setInsurance) {
+        sqlite3_bind_int(stmt, 4, patch.insuranceCompany ? 1 : 0);
+        bindText(stmt, 5, patch.insuranceCompany.value_or(""));
+    }
+    sqlite3_bind_int64(stmt, 6, id);
+    return stepUpdate(conn, stmt, id, "Patient not found");
 }
 
-void checkAndNotifyLowStock(const std::string& itemName, int quantity, sqlite3* db) {
-    if (quantity < 10) {
-        std::string message = "Low stock warning: " + itemName +
-                              " has only " + std::to_string(quantity) + " items left.";
+struct DoctorPatch {
+    std::optional<std::string_view> name;
+    std::optional<std::string_view> specialty;
+    std::optional<std::string_view> contactInfo;
+};
 
-        // Insert into the Notifications table
-        std::string query = "INSERT INTO Notifications (itemName, message) VALUES (?, ?)";
-        sqlite3_stmt* stmt;
+std::string parseDoctorPatch(const crow::json::rvalue& body, DoctorPatch& patch, bool replace) {
+    if (!getOptionalStringField(body, "name", patch.name) ||
+        !getOptionalStringField(body, "specialty", patch.specialty) ||
+        !getOptionalStringField(body, "contactInfo", patch.contactInfo)) {
+        return "name, specialty and contactInfo must be strings";
+    }
+    if (replace ? !(patch.name && patch.specialty && patch.contactInfo)
+                : !(patch.name || patch.specialty || patch.contactInfo)) {
+        return replace ? "Missing required fields: name, specialty, contactInfo"
+                       : "No fields to update: name, specialty, contactInfo";
+    }
+    return "";
+}
 
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, itemName.c_str(), -1, SQLITE_STATIC);
-            sqlite3_bind_text(stmt, 2, message.c_str(), -1, SQLITE_STATIC);
+WriteResult updateDoctor(DbConnection& conn, long long id, const DoctorPatch& patch) {
+    CachedStatement stmt = conn.prepare(
+        "UPDATE Doctors SET name = COALESCE(?1, name), specialty = COALESCE(?2, specialty), "
+        "contactInfo = COALESCE(?3, contactInfo) WHERE id = ?4");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare statement");
+    }
+    bindOptionalText(stmt, 1, patch.name);
+    bindOptionalText(stmt, 2, patch.specialty);
+    bindOptionalText(stmt, 3, patch.contactInfo);
+    sqlite3_bind_int64(stmt, 4, id);
+    return stepUpdate(conn, stmt, id, "Doctor not found");
+}
 
-            if (sqlite3_step(stmt) == SQLITE_DONE) {
-                std::cout << "Notification saved: " << message << std::endl;
-            }
-            sqlite3_finalize(stmt);
-        }
+// Rescheduling: the doctor, day and time of an appointment. The patient is fixed, as the
+// appointment's bill is theirs.
+struct AppointmentPatch {
+    std::optional<long long> doctorId;
+    std::optional<std::string_view> date;
+    std::optional<std::string_view> time;
+};
+
+std::string parseAppointmentPatch(const crow::json::rvalue& body, AppointmentPatch& patch, bool replace) {
+    if (!getOptionalIntField(body, "doctorId", patch.doctorId)) {
+        return "Invalid doctorId: expected an integer";
+    }
+    if (!getOptionalStringField(body, "date", patch.date) || !getOptionalStringField(body, "time", patch.time)) {
+        return "date and time must be strings";
+    }
+    if (replace ? !(patch.doctorId && patch.date && patch.time) : !(patch.doctorId || patch.date || patch.time)) {
+        return replace ? "Missing required fields: doctorId, date, time" : "No fields to update: doctorId, date, time";
+    }
+    // The schedule index keys doctors by int; an id outside that range cannot name a doctor
+    if (patch.doctorId && (*patch.doctorId < 1 || *patch.doctorId > std::numeric_limits<int>::max())) {
+        return "Invalid doctorId: expected a positive integer";
     }
+    if (patch.date && !isValidDate(*patch.date)) {
+        return "Invalid date. Expected a calendar date as YYYY-MM-DD";
+    }
+    if (patch.time && !isValidAppointmentTime(*patch.time)) {
+        return "Invalid time. Appointments are every 10 minutes from 09:00 to 17:00";
+    }
+    return "";
 }
 
+// Moves an appointment to another slot. The new slot is claimed in the schedule index first,
+// as for a booking; the old one is freed once the move is made and taken back if the
+// transaction rolls back. The appointment's bills follow it in the billing summaries
+// (migrations/0006_appointment_moves.sql).
+WriteResult updateAppointment(DbConnection& conn, long long id, const AppointmentPatch& patch) {
+    CachedStatement stmt = conn.prepare("SELECT doctorId, date, time FROM Appointments WHERE id = ?");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare statement");
+    }
+    sqlite3_bind_int64(stmt, 1, id);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_DONE) {
+        return writeFailure(404, "Appointment not found");
+    }
+    if (rc != SQLITE_ROW) {
+        return writeFailure(500, "Failed to read appointment");
+    }
+    int oldDoctorId = sqlite3_column_int(stmt, 0);
+    std::string oldDate = columnText(stmt, 1);
+    std::string oldTime = columnText(stmt, 2);
+
+    int doctorId = patch.doctorId ? static_cast<int>(*patch.doctorId) : oldDoctorId;
+    std::string date = patch.date ? std::string(*patch.date) : oldDate;
+    std::string time = patch.time ? std::string(*patch.time) : oldTime;
+    WriteResult result;
+    result.id = id;
+    if (doctorId == oldDoctorId && date == oldDate && time == oldTime) {
+        return result;
+    }
+    if (doctorId != oldDoctorId) {
+        try {
+            if (!findDoctor(conn, doctorId)) {
+                return writeFailure(404, "Doctor not found");
+            }
+        } catch (const std::exception& e) {
+            return writeFailure(500, e.what());
+        }
+    }
 
-void loadAppointmentsFromFile() {
-    ensureFileExists("appointments.json");
-    json arr;
-    loadFromFile("appointments.json", arr);
+    SlotReservation slot(doctorSchedule, doctorId, date, time);
+    if (!slot.reserved()) {
+        return writeFailure(409, "Appointment slot already taken");
+    }
+    Transaction txn(conn);
+    if (!txn.ok()) {
+        return writeFailure(503, "Database busy, please retry");
+    }
+    conn.onRollback([doctorId, date, time] { doctorSchedule.release(doctorId, date, time); });
+    slot.keep();
 
-    for (auto& item : arr) {
-        if (!item.contains("patientId") || !item.contains("doctorId") ||
-            !item.contains("date") || !item.contains("time")) {
-            continue;
+    stmt = conn.prepare("UPDATE Appointments SET doctorId = ?, date = ?, time = ? WHERE id = ?");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare statement");
+    }
+    sqlite3_bind_int(stmt, 1, doctorId);
+    bindText(stmt, 2, date);
+    bindText(stmt, 3, time);
+    sqlite3_bind_int64(stmt, 4, id);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        if (isUniqueViolation(conn)) {
+            // The database already holds this slot; keep it marked in the index
+            txn.rollback();
+            doctorSchedule.tryReserve(doctorId, date, time);
+            return writeFailure(409, "Appointment slot already taken");
         }
-        Appointment a;
-        a.patientId = item["patientId"].get<int>();
-        a.doctorId = item["doctorId"].get<int>();
-        a.date = item["date"].get<std::string>();
-        a.time = item["time"].get<std::string>();
-        appointments.push_back(a);
+        return writeFailure(500, "Failed to execute update");
+    }
+    doctorSchedule.release(oldDoctorId, oldDate, oldTime);
+    conn.onRollback([oldDoctorId, oldDate, oldTime] { doctorSchedule.tryReserve(oldDoctorId, oldDate, oldTime); });
+
+    if (!txn.commit()) {
+        return writeFailure(500, "Failed to commit appointment");
     }
+    return result;
 }
 
-void saveMedicalRecordsToFile() {
-    json arr = json::array();
-    for (auto& r : medicalRecords) {
-        arr.push_back({
-            {"recordId", r.recordId},
-            {"patientId", r.patientId},
-            {"visitDate", r.visitDate},
-            {"notes", r.notes},
-            {"diagnosis", r.diagnosis}
-            });
-    }
-    saveToFile("medical_records.json", arr);
+// The patient and prescribing doctor of a prescription are fixed
+struct PrescriptionPatch {
+    std::optional<std::string_view> medication;
+    std::optional<std::string_view> dosage;
+    std::optional<std::string_view> instructions;
+    std::optional<std::string_view> datePrescribed;
+};
+
+std::string parsePrescriptionPatch(const crow::json::rvalue& body, PrescriptionPatch& patch, bool replace) {
+    if (!getOptionalStringField(body, "medication", patch.medication) ||
+        !getOptionalStringField(body, "dosage", patch.dosage) ||
+        !getOptionalStringField(body, "instructions", patch.instructions) ||
+        !getOptionalStringField(body, "datePrescribed", patch.datePrescribed)) {
+        return "medication, dosage, instructions and datePrescribed must be strings";
+    }
+    if (replace ? !(patch.medication && patch.dosage && patch.instructions && patch.datePrescribed)
+                : !(patch.medication || patch.dosage || patch.instructions || patch.datePrescribed)) {
+        return replace ? "Missing required fields: medication, dosage, instructions, datePrescribed"
+                       : "No fields to update: medication, dosage, instructions, datePrescribed";
+    }
+    return "";
+}
+
+WriteResult updatePrescription(DbConnection& conn, long long id, const PrescriptionPatch& patch) {
+    CachedStatement stmt = conn.prepare(
+        "UPDATE Prescriptions SET medication = COALESCE(?1, medication), dosage = COALESCE(?2, dosage), "
+        "instructions = COALESCE(?3, instructions), datePrescribed = COALESCE(?4, datePrescribed) "
+        "WHERE prescriptionId = ?5");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare statement");
+    }
+    bindOptionalText(stmt, 1, patch.medication);
+    bindOptionalText(stmt, 2, patch.dosage);
+    bindOptionalText(stmt, 3, patch.instructions);
+    bindOptionalText(stmt, 4, patch.datePrescribed);
+    sqlite3_bind_int64(stmt, 5, id);
+    return stepUpdate(conn, stmt, id, "Prescription not found");
 }
 
-void loadMedicalRecordsFromFile() {
-    ensureFileExists("medical_records.json");
-    json arr;
-    loadFromFile("medical_records.json", arr);
+// Bill fees; totalFee is always their sum
+struct BillPatch {
+    std::optional<double> medicationFee;
+    std::optional<double> consultationFee;
+    std::optional<double> surgeryFee;
+};
 
-    for (auto& item : arr) {
-        if (!item.contains("recordId") || !item.contains("patientId") ||
-            !item.contains("visitDate") || !item.contains("notes") ||
-            !item.contains("diagnosis")) {
-            continue;
+std::string parseBillPatch(const crow::json::rvalue& body, BillPatch& patch, bool replace) {
+    if (!getOptionalNumberField(body, "medicationFee", patch.medicationFee) ||
+        !getOptionalNumberField(body, "consultationFee", patch.consultationFee) ||
+        !getOptionalNumberField(body, "surgeryFee", patch.surgeryFee)) {
+        return "Invalid fee: expected a number";
+    }
+    if (replace ? !(patch.medicationFee && patch.consultationFee && patch.surgeryFee)
+                : !(patch.medicationFee || patch.consultationFee || patch.surgeryFee)) {
+        return replace ? "Missing required fields: medicationFee, consultationFee, surgeryFee"
+                       : "No fields to update: medicationFee, consultationFee, surgeryFee";
+    }
+    for (const auto& fee : {patch.medicationFee, patch.consultationFee, patch.surgeryFee}) {
+        if (fee && *fee < 0) {
+            return "Fees cannot be negative";
         }
-        MedicalRecord r;
-        r.recordId = item["recordId"].get<int>();
-        r.patientId = item["patientId"].get<int>();
-        r.visitDate = item["visitDate"].get<std::string>();
-        r.notes = item["notes"].get<std::string>();
-        r.diagnosis = item["diagnosis"].get<std::string>();
-        medicalRecords.push_back(r);
     }
+    return "";
 }
 
-void savePrescriptionsToFile() {
-    json arr = json::array();
-    for (auto& p : prescriptions) {
-        arr.push_back({
-            {"prescriptionId", p.prescriptionId},
-            {"patientId", p.patientId},
-            {"doctorId", p.doctorId},
-            {"medication", p.medication},
-            {"dosage", p.dosage},
-            {"instructions", p.instructions},
-            {"datePrescribed", p.datePrescribed}
-            });
-    }
-    saveToFile("prescriptions.json", arr);
+WriteResult updateBill(DbConnection& conn, long long id, const BillPatch& patch) {
+    // The right-hand sides see the row's old values, so the total adds up the new fees
+    CachedStatement stmt = conn.prepare(
+        "UPDATE Bills SET medicationFee = COALESCE(?1, medicationFee), "
+        "consultationFee = COALESCE(?2, consultationFee), surgeryFee = COALESCE(?3, surgeryFee), "
+        "totalFee = COALESCE(?1, medicationFee) + COALESCE(?2, consultationFee) + COALESCE(?3, surgeryFee) "
+        "WHERE id = ?4");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare statement");
+    }
+    int index = 1;
+    for (const auto& fee : {patch.medicationFee, patch.consultationFee, patch.surgeryFee}) {
+        if (fee) {
+            sqlite3_bind_double(stmt, index, *fee);
+        } else {
+            sqlite3_bind_null(stmt, index);
+        }
+        ++index;
+    }
+    sqlite3_bind_int64(stmt, 4, id);
+    return stepUpdate(conn, stmt, id, "Bill not found");
 }
 
-void loadPrescriptionsFromFile() {
-    ensureFileExists("prescriptions.json");
-    json arr;
-    loadFromFile("prescriptions.json", arr);
-
-    for (auto& item : arr) {
-        if (!item.contains("prescriptionId") || !item.contains("patientId") ||
-            !item.contains("doctorId") || !item.contains("medication") ||
-            !item.contains("dosage") || !item.contains("instructions") ||
-            !item.contains("datePrescribed")) {
-            continue;
-        }
-        Prescription p;
-        p.prescriptionId = item["prescriptionId"].get<int>();
-        p.patientId = item["patientId"].get<int>();
-        p.doctorId = item["doctorId"].get<int>();
-        p.medication = item["medication"].get<std::string>();
-        p.dosage = item["dosage"].get<std::string>();
-        p.instructions = item["instructions"].get<std::string>();
-        p.datePrescribed = item["datePrescribed"].get<std::string>();
-        prescriptions.push_back(p);
+// The patient of a medical record is fixed
+struct MedicalRecordPatch {
+    std::optional<std::string_view> visitDate;
+    std::optional<std::string_view> notes;
+    std::optional<std::string_view> diagnosis;
+};
+
+std::string parseMedicalRecordPatch(const crow::json::rvalue& body, MedicalRecordPatch& patch, bool replace) {
+    if (!getOptionalStringField(body, "visitDate", patch.visitDate) ||
+        !getOptionalStringField(body, "notes", patch.notes) ||
+        !getOptionalStringField(body, "diagnosis", patch.diagnosis)) {
+        return "visitDate, notes and diagnosis must be strings";
     }
+    if (replace ? !(patch.visitDate && patch.notes && patch.diagnosis)
+                : !(patch.visitDate || patch.notes || patch.diagnosis)) {
+        return replace ? "Missing required fields: visitDate, notes, diagnosis"
+                       : "No fields to update: visitDate, notes, diagnosis";
+    }
+    return "";
 }
 
-void saveBillsToFile() {
-    json arr = json::array();
-    for (auto& b : bills) {
-        arr.push_back({
-            {"billId", b.billId},
-            {"patientId", b.patientId},
-            {"appointmentId", b.appointmentId},
-            {"medicationFee", b.medicationFee},
-            {"consultationFee", b.consultationFee},
-            {"surgeryFee", b.surgeryFee},
-            {"totalFee", b.totalFee},
-            {"isInsured", b.isInsured},
-            {"claimed", b.claimed},
-            {"insuranceCompany", b.insuranceCompany},
-            {"claimStatus", b.claimStatus}
-            });
-    }
-    saveToFile("bills.json", arr);
+WriteResult updateMedicalRecord(DbConnection& conn, long long id, const MedicalRecordPatch& patch) {
+    CachedStatement stmt = conn.prepare(
+        "UPDATE MedicalRecords SET visitDate = COALESCE(?1, visitDate), notes = COALESCE(?2, notes), "
+        "diagnosis = COALESCE(?3, diagnosis) WHERE recordId = ?4");
+    if (!stmt) {
+        return writeFailure(500, "Failed to prepare statement");
+    }
+    bindOptionalText(stmt, 1, patch.visitDate);
+    bindOptionalText(stmt, 2, patch.notes);
+    bindOptionalText(stmt, 3, patch.diagnosis);
+    sqlite3_bind_int64(stmt, 4, id);
+    return stepUpdate(conn, stmt, id, "Medical record not found");
 }
 
-void loadBillsFromFile() {
-    ensureFileExists("bills.json");
-    json arr;
-    loadFromFile("bills.json", arr);
-
-    for (auto& item : arr) {
-        if (!item.contains("billId") || !item.contains("patientId") ||
-            !item.contains("appointmentId") || !item.contains("medicationFee") ||
-            !item.contains("consultationFee") || !item.contains("surgeryFee") ||
-            !item.contains("totalFee") || !item.contains("isInsured") ||
-            !item.contains("claimed") || !item.contains("insuranceCompany") ||
-            !item.contains("claimStatus")) {
-            continue;
+// ------------------ Write Path ------------------
+
+// Runs a route's database work on the group-commit writer and answers once its group has
+// committed. Error responses roll back the handler's own changes without failing the group.
+template <typename Handler>
+crow::response runWrite(WriteQueue& queue, Handler handler) {
+    crow::response res;
+    bool committed = commitForRoute(queue, [&](DbConnection& conn) {
+        res = handler(conn);
+        return res.code < 400;
+    });
+    if (!committed) {
+        return crow::response(503, "Write could not be committed, please retry");
+    }
+    return res;
+}
+
+// Validates every row up front on the request thread, then writes the valid ones as a single
+// job on the writer. Responds with one result per input row, in order.
+// `committed`, if given, is called with each new id once the batch has committed.
+template <typename Input, typename Parse, typename Write>
+crow::response runBatch(WriteQueue& queue, const crow::request& req, Parse parse, Write write,
+                        void (*committed)(long long id) = nullptr) {
+    BatchBody body;
+    std::string error;
+    if (!body.parse(req, error)) {
+        return crow::response(400, error);
+    }
+
+    std::vector<Input> inputs(body.size());
+    std::vector<WriteResult> results(body.size());
+    for (size_t i = 0; i < body.size(); ++i) {
+        std::string rowError = parse(body[i], inputs[i]);
+        if (!rowError.empty()) {
+            results[i] = writeFailure(400, rowError);
         }
-        Bill b;
-        b.billId = item["billId"].get<int>();
-        b.patientId = item["patientId"].get<int>();
-        b.appointmentId = item["appointmentId"].get<int>();
-        b.medicationFee = item["medicationFee"].get<double>();
-        b.consultationFee = item["consultationFee"].get<double>();
-        b.surgeryFee = item["surgeryFee"].get<double>();
-        b.totalFee = item["totalFee"].get<double>();
-        b.isInsured = item["isInsured"].get<bool>();
-        b.claimed = item["claimed"].get<bool>();
-        b.insuranceCompany = item["insuranceCompany"].get<std::string>();
-        b.claimStatus = item["claimStatus"].get<std::string>();
-        bills.push_back(b);
     }
+
+    bool ok = commitForRoute(queue, [&](DbConnection& conn) {
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (results[i].status == 200) {
+                results[i] = write(conn, inputs[i]);
+            }
+        }
+        return true;
+    });
+    if (!ok) {
+        return crow::response(503, "Batch could not be committed, please retry");
+    }
+
+    size_t inserted = 0;
+    for (const auto& result : results) {
+        if (result.status == 200) {
+            ++inserted;
+            if (committed) {
+                committed(result.id);
+            }
+        }
+    }
+
+    crow::response res(200);
+    res.set_header("Content-Type", "application/json");
+    StringSink sink(res.body);
+    JsonStreamWriter writer(sink);
+    writer.beginObject();
+    writer.key("inserted");
+    writer.value(static_cast<long long>(inserted));
+    writer.key("failed");
+    writer.value(static_cast<long long>(results.size() - inserted));
+    writer.key("results");
+    writer.beginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const WriteResult& result = results[i];
+        writer.beginObject();
+        writer.key("index");
+        writer.value(static_cast<long long>(i));
+        writer.key("status");
+        writer.value(result.status);
+        if (result.status == 200) {
+            writer.key("id");
+            writer.value(result.id);
+            if (result.billId) {
+                writer.key("billId");
+                writer.value(result.billId);
+            }
+        } else {
+            writer.key("error");
+            writer.value(result.error);
+        }
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
+    writer.finish();
+    return res;
 }
 
-// ------------------ Utility Functions ------------------
-bool isValidAppointmentTime(const std::string& time) {
-    std::regex timeRegex(R"(^([0-1][0-9]|2[0-3]):([0-5][0-9])$)");
-    if (!std::regex_match(time, timeRegex)) {
-        return false;
-    }
-    int hour, minute;
-    char colon;
-    std::istringstream(time) >> hour >> colon >> minute;
-    // Only allow from 09:00 to 17:00
-    if (hour < 9 || hour > 17 || (hour == 17 && minute > 0)) {
-        return false;
-    }
-    // Only allow 10-minute increments
-    if (minute % 10 != 0) {
-        return false;
-    }
-    return true;
+
+// Single-record create from a JSON object body: 201 with {"id"} (and "billId" for bookings).
+// `committed`, if given, is called with the new id once it has committed.
+template <typename Input, typename Parse, typename Write>
+crow::response runCreate(WriteQueue& queue, const crow::request& req, Parse parse, Write write,
+                         void (*committed)(long long id) = nullptr) {
+    std::string error;
+    crow::json::rvalue body = loadObjectBody(req, error);
+    if (!error.empty()) {
+        return crow::response(400, error);
+    }
+    Input input;
+    error = parse(body, input);
+    if (!error.empty()) {
+        return crow::response(400, error);
+    }
+
+    WriteResult result;
+    crow::response res = runWrite(queue, [&](DbConnection& conn) {
+        result = write(conn, input);
+        return crow::response(result.status < 400 ? 201 : result.status, result.error);
+    });
+    if (res.code != 201) {
+        return res;
+    }
+    if (committed) {
+        committed(result.id);
+    }
+    res.set_header("Content-Type", "application/json");
+    StringSink sink(res.body);
+    JsonStreamWriter writer(sink);
+    writer.beginObject();
+    writer.key("id");
+    writer.value(result.id);
+    if (result.billId) {
+        writer.key("billId");
+        writer.value(result.billId);
+    }
+    writer.endObject();
+    writer.finish();
+    return res;
+}
+
+// PUT (replace) or PATCH (merge) of record `id` from a JSON object body: 200 with {"id"}.
+// `committed`, if given, is called with the id once the update has committed.
+template <typename Patch, typename Parse, typename Update>
+crow::response runUpdate(WriteQueue& queue, const crow::request& req, long long id, Parse parse, Update update,
+                         void (*committed)(long long id) = nullptr) {
+    std::string error;
+    crow::json::rvalue body = loadObjectBody(req, error);
+    if (!error.empty()) {
+        return crow::response(400, error);
+    }
+    Patch patch;
+    error = parse(body, patch, req.method == crow::HTTPMethod::PUT);
+    if (!error.empty()) {
+        return crow::response(400, error);
+    }
+
+    crow::response res = runWrite(queue, [&](DbConnection& conn) {
+        WriteResult result = update(conn, id, patch);
+        return crow::response(result.status, result.error);
+    });
+    if (res.code != 200) {
+        return res;
+    }
+    if (committed) {
+        committed(id);
+    }
+    res.set_header("Content-Type", "application/json");
+    StringSink sink(res.body);
+    JsonStreamWriter writer(sink);
+    writer.beginObject();
+    writer.key("id");
+    writer.value(id);
+    writer.endObject();
+    writer.finish();
+    return res;
 }
 
-bool isValidDate(const std::string& date) {
-    std::regex dateRegex(R"(^\d{4}-\d{2}-\d{2}$)");
-    return std::regex_match(date, dateRegex);
+
+// ------------------ Legacy Import ------------------
+// The old JSON data files go into the tables the routes read. The files were never kept in
+// step with the database, so their ids mean nothing there: every row gets a fresh id, and
+// the patient, doctor and appointment ids the other files refer to are translated through
+// the ids their rows were given. Legacy appointments have no id field; the old app appended
+// them in booking order, so appointment N is the N-th entry of appointments.json. Anything
+// that cannot be imported faithfully (a reference to a row missing from the files, a legacy
+// id used twice, a slot the database has already booked) is reported and nothing is
+// written. The import is one transaction; running it twice imports the files twice.
+
+// Legacy id -> id of the row it was imported as
+using ImportedIds = std::unordered_map<long long, long long>;
+
+// Steps an import INSERT; the new row's id, or 0 if it broke a unique index
+long long insertImported(DbConnection& conn, sqlite3_stmt* stmt) {
+    int rc = sqlite3_step(stmt);
+    long long id = rc == SQLITE_DONE ? sqlite3_last_insert_rowid(conn.handle()) : 0;
+    if (rc != SQLITE_DONE && !isUniqueViolation(conn)) {
+        throw std::runtime_error(std::string("Failed to import row: ") + sqlite3_errmsg(conn.handle()));
+    }
+    sqlite3_reset(stmt);
+    return id;
+}
+
+CachedStatement prepareImport(DbConnection& conn, const char* sql) {
+    CachedStatement stmt = conn.prepare(sql);
+    if (!stmt) {
+        throw std::runtime_error(std::string("Failed to prepare import: ") + sqlite3_errmsg(conn.handle()));
+    }
+    return stmt;
 }
 
-// Check if a specific doctor already has an appointment for the given date/time
-bool isAppointmentSlotTaken(int doctorId, const std::string& date, const std::string& time) {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    for (auto& appt : appointments) {
-        if (appt.doctorId == doctorId && appt.date == date && appt.time == time) {
-            return true;
+// All six record types in one transaction; returns the rows added. Throws, rolling
+// everything back, with a report of every row that could not be imported.
+long long importLegacyData(DbConnection& conn, const LegacyData& legacy) {
+    constexpr size_t kMaxReportedRows = 100;
+    std::vector<std::string> problems;
+    // The id a legacy reference was imported as, or 0 (and a problem) if it names no legacy row
+    auto translate = [&](const ImportedIds& ids, long long legacyId, const std::string& row, const char* target) {
+        auto it = ids.find(legacyId);
+        if (it == ids.end()) {
+            problems.push_back(row + " refers to " + target + " " + std::to_string(legacyId) + ", which is not in the files");
+            return 0LL;
+        }
+        return it->second;
+    };
+
+    Transaction txn(conn);
+    if (!txn.ok()) {
+        throw std::runtime_error("Could not start the import transaction");
+    }
+    long long inserted = 0;
+
+    ImportedIds patientIds;
+    CachedStatement stmt = prepareImport(conn,
+        "INSERT INTO Patients (name, address, medicalHistory, hasInsurance, insuranceCompany) VALUES (?, ?, ?, ?, ?)");
+    for (const Patient& p : legacy.patients) {
+        bindText(stmt, 1, p.name);
+        bindText(stmt, 2, p.address);
+        bindText(stmt, 3, p.medicalHistory);
+        sqlite3_bind_int(stmt, 4, p.hasInsurance ? 1 : 0);
+        bindText(stmt, 5, p.insuranceCompany);
+        if (!patientIds.emplace(p.id, insertImported(conn, stmt)).second) {
+            problems.push_back("patients.json uses id " + std::to_string(p.id) + " more than once");
         }
+        ++inserted;
     }
-    return false;
+
+    ImportedIds doctorIds;
+    stmt = prepareImport(conn, "INSERT INTO Doctors (name, specialty, contactInfo) VALUES (?, ?, ?)");
+    for (const Doctor& d : legacy.doctors) {
+        bindText(stmt, 1, d.name);
+        bindText(stmt, 2, d.specialty);
+        bindText(stmt, 3, d.contactInfo);
+        if (!doctorIds.emplace(d.id, insertImported(conn, stmt)).second) {
+            problems.push_back("doctors.json uses id " + std::to_string(d.id) + " more than once");
+        }
+        ++inserted;
+    }
+
+    ImportedIds appointmentIds;
+    stmt = prepareImport(conn, "INSERT INTO Appointments (patientId, doctorId, date, time) VALUES (?, ?, ?, ?)");
+    for (size_t i = 0; i < legacy.appointments.size(); ++i) {
+        const Appointment& a = legacy.appointments[i];
+        std::string row = "appointment " + std::to_string(i + 1);
+        sqlite3_bind_int64(stmt, 1, translate(patientIds, a.patientId, row, "patient"));
+        sqlite3_bind_int64(stmt, 2, translate(doctorIds, a.doctorId, row, "doctor"));
+        bindText(stmt, 3, a.date);
+        bindText(stmt, 4, a.time);
+        long long id = insertImported(conn, stmt);
+        if (id == 0) {
+            problems.push_back(row + " (" + a.date + " " + a.time + ") is already booked for its doctor");
+        }
+        appointmentIds.emplace(static_cast<long long>(i + 1), id);
+        ++inserted;
+    }
+
+    stmt = prepareImport(conn, "INSERT INTO MedicalRecords (patientId, visitDate, notes, diagnosis) VALUES (?, ?, ?, ?)");
+    for (const MedicalRecord& r : legacy.medicalRecords) {
+        std::string row = "medical record " + std::to_string(r.recordId);
+        sqlite3_bind_int64(stmt, 1, translate(patientIds, r.patientId, row, "patient"));
+        bindText(stmt, 2, r.visitDate);
+        bindText(stmt, 3, r.notes);
+        bindText(stmt, 4, r.diagnosis);
+        insertImported(conn, stmt);
+        ++inserted;
+    }
+
+    stmt = prepareImport(conn,
+        "INSERT INTO Prescriptions (patientId, doctorId, medication, dosage, instructions, datePrescribed) "
+        "VALUES (?, ?, ?, ?, ?, ?)");
+    for (const Prescription& p : legacy.prescriptions) {
+        std::string row = "prescription " + std::to_string(p.prescriptionId);
+        sqlite3_bind_int64(stmt, 1, translate(patientIds, p.patientId, row, "patient"));
+        sqlite3_bind_int64(stmt, 2, translate(doctorIds, p.doctorId, row, "doctor"));
+        bindText(stmt, 3, p.medication);
+        bindText(stmt, 4, p.dosage);
+        bindText(stmt, 5, p.instructions);
+        bindText(stmt, 6, p.datePrescribed);
+        insertImported(conn, stmt);
+        ++inserted;
+    }
+
+    stmt = prepareImport(conn,
+        "INSERT INTO Bills (patientId, appointmentId, medicationFee, consultationFee, surgeryFee, totalFee, "
+        "isInsured, claimed, insuranceCompany, claimStatus) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    for (const Bill& b : legacy.bills) {
+        std::string row = "bill " + std::to_string(b.billId);
+        sqlite3_bind_int64(stmt, 1, translate(patientIds, b.patientId, row, "patient"));
+        sqlite3_bind_int64(stmt, 2, translate(appointmentIds, b.appointmentId, row, "appointment"));
+        sqlite3_bind_double(stmt, 3, b.medicationFee);
+        sqlite3_bind_double(stmt, 4, b.consultationFee);
+        sqlite3_bind_double(stmt, 5, b.surgeryFee);
+        sqlite3_bind_double(stmt, 6, b.totalFee);
+        sqlite3_bind_int(stmt, 7, b.isInsured ? 1 : 0);
+        sqlite3_bind_int(stmt, 8, b.claimed ? 1 : 0);
+        bindText(stmt, 9, b.insuranceCompany);
+        bindText(stmt, 10, b.claimStatus);
+        insertImported(conn, stmt);
+        ++inserted;
+    }
+
+    if (!problems.empty()) {
+        std::string report;
+        for (size_t i = 0; i < problems.size() && i < kMaxReportedRows; ++i) {
+            report += "\n  " + problems[i];
+        }
+        if (problems.size() > kMaxReportedRows) {
+            report += "\n  ... and " + std::to_string(problems.size() - kMaxReportedRows) + " more";
+        }
+        throw std::runtime_error("Nothing was imported; these rows cannot be imported faithfully:" + report);
+    }
+    if (!txn.commit()) {
+        throw std::runtime_error(std::string("Failed to commit the import: ") + sqlite3_errmsg(conn.handle()));
+    }
+    return inserted;
 }
 
 
-int main() {
-    crow::SimpleApp app;
+int main(int argc, char* argv[]) {
+    // RequestMetrics times every route; see /metrics
+    // ResponseCompression runs its after_handle first, so metrics see the bytes actually sent
+    crow::App<RequestMetrics, ResponseCompression> app;
+    RequestMetrics& metrics = app.get_middleware<RequestMetrics>();
+    bool checkPlansOnly = argc > 1 && std::string(argv[1]) == "--check-query-plans";
+    bool importLegacyOnly = argc > 1 && std::string(argv[1]) == "--import-legacy";
 
+    StorageProfile storageProfile;
     sqlite3* db = nullptr;
     try {
-        db = initDatabase("healthcare.db", "database.sql");
+        storageProfile = loadStorageProfile("storage.json");
+        db = initDatabase("healthcare.db", "database.sql", storageProfile);
+        applyMigrations(db, "migrations");
     } catch (const std::exception& e) {
         std::cerr << "Error initializing database: " << e.what() << std::endl;
+        if (db) {
+            sqlite3_close(db);
+        }
+        return 1;
+    }
+
+    // `app --import-legacy` copies the old *.json data files (read all six in parallel) into the database
+    if (importLegacyOnly) {
+        sqlite3_close(db);
+        try {
+            LegacyData legacy = loadLegacyData("");
+            std::cout << "Importing " << legacy.patients.size() << " patients, " << legacy.doctors.size() << " doctors, "
+                      << legacy.appointments.size() << " appointments, " << legacy.medicalRecords.size() << " medical records, "
+                      << legacy.prescriptions.size() << " prescriptions, " << legacy.bills.size() << " bills." << std::endl;
+            DbConnection conn("healthcare.db", storageProfile);
+            long long inserted = importLegacyData(conn, legacy);
+            std::cout << "Imported " << inserted << " rows." << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error importing legacy data: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Hot lookups must stay index-driven; `app --check-query-plans` fails on any table scan (for CI)
+    std::vector<std::string> tableScans = findTableScans(db);
+    for (const auto& scan : tableScans) {
+        std::cerr << "Query plan regression: " << scan << std::endl;
+    }
+    if (checkPlansOnly) {
+        sqlite3_close(db);
+        std::cout << (tableScans.empty() ? "All hot-path queries use indexes." : "Table scans found.") << std::endl;
+        return tableScans.empty() ? 0 : 1;
+    }
+
+    // The bootstrap connection only applies the schema; request handlers use per-thread pooled connections
+    sqlite3_close(db);
+    ConnectionPool pool("healthcare.db", storageProfile);
+    pool.onOpen([&metrics](DbConnection& conn) { metrics.instrument(conn); });
+    CheckpointWorker checkpointer("healthcare.db", storageProfile);
+    // Every mutating route commits through this single writer, which also bumps the table versions
+    TableVersions tableVersions;
+    WriteQueue writeQueue(pool, storageProfile, &tableVersions);
+    // The newest notifications stay in memory for cursor reads and are pushed to WebSocket subscribers
+    NotificationFeed notificationFeed(4096);
+    try {
+        notificationFeed.load(pool.local());
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading notifications: " << e.what() << std::endl;
+        return 1;
+    }
+    // Raises low-stock notifications off the request path, once per item until it is restocked
+    LowStockEvaluator lowStockEvaluator(writeQueue, tableVersions, notificationFeed, std::chrono::milliseconds(200));
+    // Adjudicates pending insurance claims in the background when storage.json enables it;
+    // otherwise claims wait for /approve_insurance
+    LocalInsurerStub insurer;
+    std::optional<ClaimProcessor> claimProcessor;
+    if (storageProfile.claimProcessorEnabled) {
+        claimProcessor.emplace(pool, writeQueue, insurer, storageProfile.claimProcessorWorkers,
+                               storageProfile.claimProcessorBatchSize, std::chrono::seconds(1));
+        std::cout << "Claim processor enabled: claims are decided by the insurer stub." << std::endl;
+    }
+    // Serialized list pages, revalidated by table version (ETag / If-None-Match)
+    ResponseCache responseCache(tableVersions, 4096, 1 << 20);
+    // Billing reports from the trigger-maintained summaries, rebuilt at most once a second
+    BillingAnalytics billingAnalytics(tableVersions, std::chrono::seconds(1));
+    try {
+        size_t bookedSlots = doctorSchedule.load(pool.local());
+        std::cout << "Schedule index loaded with " << bookedSlots << " booked slots." << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading schedule index: " << e.what() << std::endl;
         return 1;
     }
-    // Load existing data
-    loadPatientsFromFile();
-    loadDoctorsFromFile();
-    loadAppointmentsFromFile();
-    loadMedicalRecordsFromFile();
-    loadPrescriptionsFromFile();
-    loadBillsFromFile();
 
     // Home route
     CROW_ROUTE(app, "/")([]() {
@@ -453,7 +1178,7 @@ int main() {
 
     //  Register new patient
     // Example: /register?name=John&address=NY&medicalHistory=SomeHistory&insuranceCompany=XYZ
-   CROW_ROUTE(app, "/register").methods(crow::HTTPMethod::GET)([&db](const crow::request& req) {
+   CROW_ROUTE(app, "/register").methods(crow::HTTPMethod::GET)([&writeQueue](const crow::request& req) {
     auto qs = req.url_params;
 
     const char* name = qs.get("name");
@@ -465,33 +1190,31 @@ int main() {
         return crow::response(400, "Missing required parameters: name, address, medicalHistory");
     }
 
-    bool hasInsurance = (insuranceCompany != nullptr); // If insuranceCompany exists, set hasInsurance to true
-
-    // Insert into SQLite
-    std::string sql = "INSERT INTO Patients (name, address, medicalHistory, hasInsurance, insuranceCompany) VALUES (?, ?, ?, ?, ?)";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
+    // If insuranceCompany exists, set hasInsurance to true
+    PatientInput patient{name, address, medicalHistory, std::nullopt};
+    if (insuranceCompany) {
+        patient.insuranceCompany = insuranceCompany;
     }
 
-    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, address, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, medicalHistory, -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 4, hasInsurance ? 1 : 0);
-    sqlite3_bind_text(stmt, 5, insuranceCompany ? insuranceCompany : "", -1, SQLITE_STATIC);
-
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return crow::response(500, "Failed to execute statement");
-    }
-
-    int id = sqlite3_last_insert_rowid(db);
-    sqlite3_finalize(stmt);
-
-    crow::json::wvalue resp;
-    resp["message"] = "Patient registered successfully";
-    resp["id"] = id;
-    return crow::response(resp);
+    long long newId = 0;
+    crow::response res = runWrite(writeQueue, [&](DbConnection& conn) {
+        // Insert into SQLite
+        WriteResult result = insertPatient(conn, patient);
+        if (result.status != 200) {
+            return crow::response(result.status, result.error);
+        }
+        int id = newId = result.id;
+
+        crow::json::wvalue resp;
+        resp["message"] = "Patient registered successfully";
+        resp["id"] = id;
+        return crow::response(resp);
+    });
+    // Committed (or failed) by now; drop any cached "not found" for the new id
+    if (newId) {
+        patientCache.erase(newId);
+    }
+    return res;
 });
 
 
@@ -499,7 +1222,7 @@ int main() {
     // Example:
     // /book_appointment?patientId=1&doctorId=1&date=2025-01-02&time=09:00
     // After booking, automatically add a Bill (with 0 fees) create or update a medicalRecord for the patient's appointment history
- CROW_ROUTE(app, "/book_appointment").methods(crow::HTTPMethod::GET)([&db](const crow::request& req) {
+ CROW_ROUTE(app, "/book_appointment").methods(crow::HTTPMethod::GET)([&writeQueue](const crow::request& req) {
     auto qs = req.url_params;
     const char* patientIdStr = qs.get("patientId");
     const char* doctorIdStr = qs.get("doctorId");
@@ -510,108 +1233,89 @@ int main() {
         return crow::response(400, "Missing required parameters: patientId, doctorId, date, time");
     }
 
-    int patientId = std::atoi(patientIdStr);
-    int doctorId = std::atoi(doctorIdStr);
-
-    // Insert appointment
-    std::string insertAppointment = "INSERT INTO Appointments (patientId, doctorId, date, time) VALUES (?, ?, ?, ?)";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, insertAppointment.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare appointment statement");
+    int patientId, doctorId;
+    if (!parseIntParam(patientIdStr, patientId) || !parseIntParam(doctorIdStr, doctorId)) {
+        return crow::response(400, "Invalid patientId or doctorId: expected integers");
     }
-    sqlite3_bind_int(stmt, 1, patientId);
-    sqlite3_bind_int(stmt, 2, doctorId);
-    sqlite3_bind_text(stmt, 3, date, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, time, -1, SQLITE_STATIC);
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return crow::response(500, "Failed to execute appointment statement");
-    }
-    int appointmentId = sqlite3_last_insert_rowid(db);
-    sqlite3_finalize(stmt);
-
-    // Insert bill
-    std::string insertBill = "INSERT INTO Bills (patientId, appointmentId, isInsured) VALUES (?, ?, ?)";
-    if (sqlite3_prepare_v2(db, insertBill.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare bill statement");
-    }
-    sqlite3_bind_int(stmt, 1, patientId);
-    sqlite3_bind_int(stmt, 2, appointmentId);
-    sqlite3_bind_int(stmt, 3, 0);  // Example: no insurance for simplicity
-
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return crow::response(500, "Failed to execute bill statement");
-    }
-    int billId = sqlite3_last_insert_rowid(db);
-    sqlite3_finalize(stmt);
-
-    crow::json::wvalue resp;
-    resp["message"] = "Appointment and bill created successfully";
-    resp["appointmentId"] = appointmentId;
-    resp["billId"] = billId;
-    return crow::response(resp);
+    return runWrite(writeQueue, [&](DbConnection& conn) {
+        WriteResult result = bookAppointment(conn, {patientId, doctorId, date, time});
+        if (result.status != 200) {
+            return crow::response(result.status, result.error);
+        }
+        int appointmentId = result.id;
+        int billId = result.billId;
+
+        crow::json::wvalue resp;
+        resp["message"] = "Appointment and bill created successfully";
+        resp["appointmentId"] = appointmentId;
+        resp["billId"] = billId;
+        return crow::response(resp);
+    });
 });
 
 
-    //  view all patients 
-    // Show each patient's prescriptions in the response
+    // Free and booked slots for one doctor on one day, answered from the in-memory schedule
+    // Example: /availability?doctorId=1&date=2025-01-02
+    CROW_ROUTE(app, "/availability").methods(crow::HTTPMethod::GET)([](const crow::request& req) {
+    auto qs = req.url_params;
+    const char* doctorIdStr = qs.get("doctorId");
+    const char* date = qs.get("date");
 
-    CROW_ROUTE(app, "/patients").methods(crow::HTTPMethod::GET)([&db]() {
-    std::string query = "SELECT * FROM Patients";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
+    if (!doctorIdStr || !date) {
+        return crow::response(400, "Missing required parameters: doctorId, date");
+    }
+    if (!isValidDate(date)) {
+        return crow::response(400, "Invalid date. Expected a calendar date as YYYY-MM-DD");
     }
 
-    crow::json::wvalue resp;
-    std::vector<crow::json::wvalue> patientsArray;
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        crow::json::wvalue patient;
-        patient["id"] = sqlite3_column_int(stmt, 0);
-        patient["name"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        patient["address"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        patient["medicalHistory"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        patient["hasInsurance"] = sqlite3_column_int(stmt, 4);
-        patient["insuranceCompany"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-
-        patientsArray.push_back(patient);
+    int doctorId;
+    if (!parseIntParam(doctorIdStr, doctorId)) {
+        return crow::response(400, "Invalid doctorId: expected an integer");
+    }
+    uint64_t booked = doctorSchedule.bookedMask(doctorId, date);
+
+    std::vector<crow::json::wvalue> available;
+    std::vector<crow::json::wvalue> taken;
+    for (int slot = 0; slot < kSlotsPerDay; ++slot) {
+        if (booked >> slot & 1) {
+            taken.push_back(timeForSlot(slot));
+        } else {
+            available.push_back(timeForSlot(slot));
+        }
     }
-    sqlite3_finalize(stmt);
 
-    resp["patients"] = std::move(patientsArray);
+    crow::json::wvalue resp;
+    resp["doctorId"] = doctorId;
+    resp["date"] = date;
+    resp["available"] = std::move(available);
+    resp["booked"] = std::move(taken);
     return crow::response(resp);
 });
 
 
+    //  view patients, one page at a time
+    // Example: /patients?limit=100&after_id=200&insuranceCompany=XYZ
+    // List, export and timeline routes answer in CBOR or MessagePack instead of JSON for
+    // "Accept: application/cbor" or "Accept: application/msgpack" (see response_format.h)
 
-    // view all appointments 
+    CROW_ROUTE(app, "/patients").methods(crow::HTTPMethod::GET)([&pool, &responseCache](const crow::request& req) {
+    const ListSpec& spec = patientListSpec();
+    BodyFormat format = negotiateFormat(req);
+    return responseCache.serve(
+        req, spec.table, [&] { return listPage(pool.local(), spec, req.url_params, format); }, formatName(format));
+});
 
-CROW_ROUTE(app, "/appointments").methods(crow::HTTPMethod::GET)([&db]() {
-    std::string query = "SELECT * FROM Appointments";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
-    }
 
-    crow::json::wvalue resp;
-    std::vector<crow::json::wvalue> appointmentsArray;
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        crow::json::wvalue appointment;
-        appointment["id"] = sqlite3_column_int(stmt, 0);
-        appointment["patientId"] = sqlite3_column_int(stmt, 1);
-        appointment["doctorId"] = sqlite3_column_int(stmt, 2);
-        appointment["date"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        appointment["time"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-        appointmentsArray.push_back(std::move(appointment));
-    }
-    sqlite3_finalize(stmt);
+    // view appointments, one page at a time
+    // Example: /appointments?doctorId=1&date=2025-01-02&limit=50
 
-    resp["appointments"] = std::move(appointmentsArray);
-    return crow::response(resp);
+CROW_ROUTE(app, "/appointments").methods(crow::HTTPMethod::GET)([&pool, &responseCache](const crow::request& req) {
+    const ListSpec& spec = appointmentListSpec();
+    BodyFormat format = negotiateFormat(req);
+    return responseCache.serve(
+        req, spec.table, [&] { return listPage(pool.local(), spec, req.url_params, format); }, formatName(format));
 });
 
 
@@ -619,7 +1323,7 @@ CROW_ROUTE(app, "/appointments").methods(crow::HTTPMethod::GET)([&db]() {
     // Rregister a new doctor 
     // Example:
     // /register_doctor?name=DrSmith&specialty=Surgery&contactInfo=xxx
-CROW_ROUTE(app, "/register_doctor").methods(crow::HTTPMethod::GET)([&db](const crow::request& req) {
+CROW_ROUTE(app, "/register_doctor").methods(crow::HTTPMethod::GET)([&writeQueue](const crow::request& req) {
     auto qs = req.url_params;
     const char* name = qs.get("name");
     const char* specialty = qs.get("specialty");
@@ -629,63 +1333,43 @@ CROW_ROUTE(app, "/register_doctor").methods(crow::HTTPMethod::GET)([&db](const c
         return crow::response(400, "Missing required parameters: name, specialty, contactInfo");
     }
 
-    std::string sql = "INSERT INTO Doctors (name, specialty, contactInfo) VALUES (?, ?, ?)";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
-    }
-
-    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, specialty, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, contactInfo, -1, SQLITE_STATIC);
-
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return crow::response(500, "Failed to execute statement");
-    }
-
-    int id = sqlite3_last_insert_rowid(db);
-    sqlite3_finalize(stmt);
-
-    crow::json::wvalue resp;
-    resp["message"] = "Doctor registered successfully";
-    resp["id"] = id;
-    return crow::response(resp);
+    long long newId = 0;
+    crow::response res = runWrite(writeQueue, [&](DbConnection& conn) {
+        WriteResult result = insertDoctor(conn, {name, specialty, contactInfo});
+        if (result.status != 200) {
+            return crow::response(result.status, result.error);
+        }
+        int id = newId = result.id;
+
+        crow::json::wvalue resp;
+        resp["message"] = "Doctor registered successfully";
+        resp["id"] = id;
+        return crow::response(resp);
+    });
+    // Committed (or failed) by now; drop any cached "not found" for the new id
+    if (newId) {
+        doctorCache.erase(newId);
+    }
+    return res;
 });
 
 
 
-    // view doctors 
-
-   CROW_ROUTE(app, "/doctors").methods(crow::HTTPMethod::GET)([&db]() {
-    std::string query = "SELECT * FROM Doctors";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
-    }
-
-    crow::json::wvalue resp;
-    std::vector<crow::json::wvalue> doctorsArray;
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        crow::json::wvalue doctor;
-        doctor["id"] = sqlite3_column_int(stmt, 0);
-        doctor["name"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        doctor["specialty"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        doctor["contactInfo"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        doctorsArray.push_back(std::move(doctor));
-    }
-    sqlite3_finalize(stmt);
+    // view doctors, one page at a time
+    // Example: /doctors?specialty=Surgery&after_id=20
 
-    resp["doctors"] = std::move(doctorsArray);
-    return crow::response(resp);
+   CROW_ROUTE(app, "/doctors").methods(crow::HTTPMethod::GET)([&pool, &responseCache](const crow::request& req) {
+    const ListSpec& spec = doctorListSpec();
+    BodyFormat format = negotiateFormat(req);
+    return responseCache.serve(
+        req, spec.table, [&] { return listPage(pool.local(), spec, req.url_params, format); }, formatName(format));
 });
 
 
     // Add prescription 
     // Example:
     // /add_prescription?patientId=1&doctorId=1&medication=ABC&dosage=1tablet&instructions=AfterMeal&datePrescribed=2025-01-02
-    CROW_ROUTE(app, "/add_prescription").methods(crow::HTTPMethod::GET)([&db](const crow::request& req) {
+    CROW_ROUTE(app, "/add_prescription").methods(crow::HTTPMethod::GET)([&writeQueue](const crow::request& req) {
     auto qs = req.url_params;
     const char* patientIdStr = qs.get("patientId");
     const char* doctorIdStr = qs.get("doctorId");
@@ -698,98 +1382,158 @@ CROW_ROUTE(app, "/register_doctor").methods(crow::HTTPMethod::GET)([&db](const c
         return crow::response(400, "Missing required parameters");
     }
 
-    int patientId = std::atoi(patientIdStr);
-    int doctorId = std::atoi(doctorIdStr);
-
-    // Validate patient
-    std::string checkPatient = "SELECT id FROM Patients WHERE id = ?";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, checkPatient.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare patient check statement");
-    }
-    sqlite3_bind_int(stmt, 1, patientId);
-    if (sqlite3_step(stmt) != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
-        return crow::response(404, "Patient not found");
+    int patientId, doctorId;
+    if (!parseIntParam(patientIdStr, patientId) || !parseIntParam(doctorIdStr, doctorId)) {
+        return crow::response(400, "Invalid patientId or doctorId: expected integers");
     }
-    sqlite3_finalize(stmt);
 
-    // Validate doctor
-    std::string checkDoctor = "SELECT id FROM Doctors WHERE id = ?";
-    if (sqlite3_prepare_v2(db, checkDoctor.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare doctor check statement");
-    }
-    sqlite3_bind_int(stmt, 1, doctorId);
-    if (sqlite3_step(stmt) != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
-        return crow::response(404, "Doctor not found");
+    return runWrite(writeQueue, [&](DbConnection& conn) {
+        WriteResult result = addPrescription(conn, {patientId, doctorId, medication, dosage, instructions, datePrescribed});
+        if (result.status != 200) {
+            return crow::response(result.status, result.error);
+        }
+        int prescriptionId = result.id;
+
+        crow::json::wvalue resp;
+        resp["message"] = "Prescription added successfully";
+        resp["prescriptionId"] = prescriptionId;
+        return crow::response(resp);
+    });
+});
+
+    // Example:
+    // /add_medical_record?patientId=1&visitDate=2025-01-02&notes=Follow-up&diagnosis=Healthy
+    CROW_ROUTE(app, "/add_medical_record").methods(crow::HTTPMethod::GET)([&writeQueue](const crow::request& req) {
+    auto qs = req.url_params;
+    const char* patientIdStr = qs.get("patientId");
+    const char* visitDate = qs.get("visitDate");
+    const char* notes = qs.get("notes");
+    const char* diagnosis = qs.get("diagnosis");
+
+    if (!patientIdStr || !visitDate || !notes || !diagnosis) {
+        return crow::response(400, "Missing required parameters");
     }
-    sqlite3_finalize(stmt);
 
-    // Insert prescription
-    std::string sql = "INSERT INTO Prescriptions (patientId, doctorId, medication, dosage, instructions, datePrescribed) VALUES (?, ?, ?, ?, ?, ?)";
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare prescription statement");
+    int patientId;
+    if (!parseIntParam(patientIdStr, patientId)) {
+        return crow::response(400, "Invalid patientId: expected an integer");
     }
 
-    sqlite3_bind_int(stmt, 1, patientId);
-    sqlite3_bind_int(stmt, 2, doctorId);
-    sqlite3_bind_text(stmt, 3, medication, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, dosage, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 5, instructions, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 6, datePrescribed, -1, SQLITE_STATIC);
+    return runWrite(writeQueue, [&](DbConnection& conn) {
+        WriteResult result = addMedicalRecord(conn, {patientId, visitDate, notes, diagnosis});
+        if (result.status != 200) {
+            return crow::response(result.status, result.error);
+        }
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return crow::response(500, "Failed to execute prescription statement");
-    }
+        crow::json::wvalue resp;
+        resp["message"] = "Medical record added successfully";
+        resp["recordId"] = result.id;
+        return crow::response(resp);
+    });
+});
 
-    int prescriptionId = sqlite3_last_insert_rowid(db);
-    sqlite3_finalize(stmt);
+    // Bulk variants: POST a JSON array (or NDJSON, one object per line) with the same fields as the
+    // single-record routes. All valid rows are inserted in one transaction; the response has one
+    // result per row (status, id or error).
+    // Example: POST /register/batch  [{"name":"John","address":"NY","medicalHistory":"None"}, ...]
+    CROW_ROUTE(app, "/register/batch").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runBatch<PatientInput>(writeQueue, req, parsePatientRow, insertPatient,
+                                  [](long long id) { patientCache.erase(id); });
+});
 
-    crow::json::wvalue resp;
-    resp["message"] = "Prescription added successfully";
-    resp["prescriptionId"] = prescriptionId;
-    return crow::response(resp);
+    // Example: POST /book_appointment/batch  [{"patientId":1,"doctorId":1,"date":"2025-01-02","time":"09:00"}, ...]
+    CROW_ROUTE(app, "/book_appointment/batch").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runBatch<AppointmentInput>(writeQueue, req, parseAppointmentRow, bookAppointment);
 });
 
-    //  View /bills (GET)
-CROW_ROUTE(app, "/bills").methods(crow::HTTPMethod::GET)([&db]() {
-    std::string sql = "SELECT * FROM Bills";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
-    }
+    // Example: POST /add_prescription/batch  [{"patientId":1,"doctorId":1,"medication":"ABC","dosage":"1tablet",
+    //                                          "instructions":"AfterMeal","datePrescribed":"2025-01-02"}, ...]
+    CROW_ROUTE(app, "/add_prescription/batch").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runBatch<PrescriptionInput>(writeQueue, req, parsePrescriptionRow, addPrescription);
+});
 
-    crow::json::wvalue resp;
-    std::vector<crow::json::wvalue> bills;
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        crow::json::wvalue bill;
-        bill["id"] = sqlite3_column_int(stmt, 0);
-        bill["patientId"] = sqlite3_column_int(stmt, 1);
-        bill["appointmentId"] = sqlite3_column_int(stmt, 2);
-        bill["medicationFee"] = sqlite3_column_double(stmt, 3);
-        bill["consultationFee"] = sqlite3_column_double(stmt, 4);
-        bill["surgeryFee"] = sqlite3_column_double(stmt, 5);
-        bill["totalFee"] = sqlite3_column_double(stmt, 6);
-        bill["isInsured"] = sqlite3_column_int(stmt, 7);
-        bill["claimed"] = sqlite3_column_int(stmt, 8);
-        bill["insuranceCompany"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9));
-        bill["claimStatus"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10));
-        bills.push_back(std::move(bill));
-    }
-    sqlite3_finalize(stmt);
-
-    resp["bills"] = std::move(bills);
-    return crow::response(resp);
+    // Example: POST /add_medical_record/batch  [{"patientId":1,"visitDate":"2025-01-02","notes":"Follow-up",
+    //                                           "diagnosis":"Healthy"}, ...]
+    CROW_ROUTE(app, "/add_medical_record/batch").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runBatch<MedicalRecordInput>(writeQueue, req, parseMedicalRecordRow, addMedicalRecord);
+});
+
+    // REST forms of the write routes: POST a JSON object to a collection to create a record
+    // (201 with its id), PUT a full object to replace a record or PATCH some of its fields.
+    // String fields are bound to SQLite straight from the parsed body.
+    // Example: POST /patients  {"name":"John","address":"NY","medicalHistory":"None","insuranceCompany":"Acme"}
+    //          PATCH /patients/1  {"insuranceCompany":null}
+    CROW_ROUTE(app, "/patients").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runCreate<PatientInput>(writeQueue, req, parsePatientRow, insertPatient,
+                                   [](long long id) { patientCache.erase(id); });
+});
+
+    CROW_ROUTE(app, "/patients/<int>").methods(crow::HTTPMethod::PUT, crow::HTTPMethod::PATCH)([&writeQueue](const crow::request& req, int id) {
+    return runUpdate<PatientPatch>(writeQueue, req, id, parsePatientPatch, updatePatient,
+                                   [](long long updated) { patientCache.erase(updated); });
+});
+
+    CROW_ROUTE(app, "/doctors").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runCreate<DoctorInput>(writeQueue, req, parseDoctorRow, insertDoctor,
+                                  [](long long id) { doctorCache.erase(id); });
+});
+
+    CROW_ROUTE(app, "/doctors/<int>").methods(crow::HTTPMethod::PUT, crow::HTTPMethod::PATCH)([&writeQueue](const crow::request& req, int id) {
+    return runUpdate<DoctorPatch>(writeQueue, req, id, parseDoctorPatch, updateDoctor,
+                                  [](long long updated) { doctorCache.erase(updated); });
+});
+
+    // Example: POST /appointments  {"patientId":1,"doctorId":1,"date":"2025-01-02","time":"09:00"} -> {"id","billId"}
+    CROW_ROUTE(app, "/appointments").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runCreate<AppointmentInput>(writeQueue, req, parseAppointmentRow, bookAppointment);
+});
+
+    // Reschedules; the new slot must be free. Example: PATCH /appointments/1  {"time":"10:30"}
+    CROW_ROUTE(app, "/appointments/<int>").methods(crow::HTTPMethod::PUT, crow::HTTPMethod::PATCH)([&writeQueue](const crow::request& req, int id) {
+    return runUpdate<AppointmentPatch>(writeQueue, req, id, parseAppointmentPatch, updateAppointment);
+});
+
+    CROW_ROUTE(app, "/prescriptions").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runCreate<PrescriptionInput>(writeQueue, req, parsePrescriptionRow, addPrescription);
+});
+
+    CROW_ROUTE(app, "/prescriptions/<int>").methods(crow::HTTPMethod::PUT, crow::HTTPMethod::PATCH)([&writeQueue](const crow::request& req, int id) {
+    return runUpdate<PrescriptionPatch>(writeQueue, req, id, parsePrescriptionPatch, updatePrescription);
+});
+
+    // Example: PATCH /bills/1  {"surgeryFee":250.0}
+    CROW_ROUTE(app, "/bills/<int>").methods(crow::HTTPMethod::PUT, crow::HTTPMethod::PATCH)([&writeQueue](const crow::request& req, int id) {
+    return runUpdate<BillPatch>(writeQueue, req, id, parseBillPatch, updateBill);
+});
+
+    CROW_ROUTE(app, "/medical_records").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runCreate<MedicalRecordInput>(writeQueue, req, parseMedicalRecordRow, addMedicalRecord);
+});
+
+    CROW_ROUTE(app, "/medical_records/<int>").methods(crow::HTTPMethod::PUT, crow::HTTPMethod::PATCH)([&writeQueue](const crow::request& req, int id) {
+    return runUpdate<MedicalRecordPatch>(writeQueue, req, id, parseMedicalRecordPatch, updateMedicalRecord);
+});
+
+    // A patient's appointments, bills, prescriptions and medical records, merged by date
+    // Example: /patients/1/timeline
+    CROW_ROUTE(app, "/patients/<int>/timeline").methods(crow::HTTPMethod::GET)([&pool](const crow::request& req, int patientId) {
+    return patientTimeline(pool.local(), patientId, negotiateFormat(req));
+});
+
+    //  View /bills (GET), one page at a time
+    // Example: /bills?claimStatus=Pending&limit=200&after_id=1000
+CROW_ROUTE(app, "/bills").methods(crow::HTTPMethod::GET)([&pool, &responseCache](const crow::request& req) {
+    const ListSpec& spec = billListSpec();
+    BodyFormat format = negotiateFormat(req);
+    return responseCache.serve(
+        req, spec.table, [&] { return listPage(pool.local(), spec, req.url_params, format); }, formatName(format));
 });
 
 
 
     // Example:
     // /update_bill?billId=1&medicationFee=10.0&consultationFee=20.0&surgeryFee=0.0
- CROW_ROUTE(app, "/update_bill").methods(crow::HTTPMethod::GET)([&db](const crow::request& req) {
+ CROW_ROUTE(app, "/update_bill").methods(crow::HTTPMethod::GET)([&writeQueue](const crow::request& req) {
     auto qs = req.url_params;
     const char* billIdStr = qs.get("billId");
     const char* medicationFeeStr = qs.get("medicationFee");
@@ -800,41 +1544,49 @@ CROW_ROUTE(app, "/bills").methods(crow::HTTPMethod::GET)([&db]() {
         return crow::response(400, "Missing required parameters");
     }
 
-    int billId = std::atoi(billIdStr);
-    double medicationFee = std::atof(medicationFeeStr);
-    double consultationFee = std::atof(consultationFeeStr);
-    double surgeryFee = std::atof(surgeryFeeStr);
+    int billId;
+    if (!parseIntParam(billIdStr, billId)) {
+        return crow::response(400, "Invalid billId: expected an integer");
+    }
+    double medicationFee, consultationFee, surgeryFee;
+    if (!parseDoubleParam(medicationFeeStr, medicationFee) || !parseDoubleParam(consultationFeeStr, consultationFee) ||
+        !parseDoubleParam(surgeryFeeStr, surgeryFee)) {
+        return crow::response(400, "Invalid fee: expected a number");
+    }
+    if (medicationFee < 0 || consultationFee < 0 || surgeryFee < 0) {
+        return crow::response(400, "Fees cannot be negative");
+    }
     double totalFee = medicationFee + consultationFee + surgeryFee;
 
     std::string query = "UPDATE Bills SET medicationFee = ?, consultationFee = ?, surgeryFee = ?, totalFee = ? WHERE id = ?";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
-    }
+    return runWrite(writeQueue, [&](DbConnection& conn) {
+        CachedStatement stmt = conn.prepare(query);
+        if (!stmt) {
+            return crow::response(500, "Failed to prepare statement");
+        }
 
-    sqlite3_bind_double(stmt, 1, medicationFee);
-    sqlite3_bind_double(stmt, 2, consultationFee);
-    sqlite3_bind_double(stmt, 3, surgeryFee);
-    sqlite3_bind_double(stmt, 4, totalFee);
-    sqlite3_bind_int(stmt, 5, billId);
+        sqlite3_bind_double(stmt, 1, medicationFee);
+        sqlite3_bind_double(stmt, 2, consultationFee);
+        sqlite3_bind_double(stmt, 3, surgeryFee);
+        sqlite3_bind_double(stmt, 4, totalFee);
+        sqlite3_bind_int(stmt, 5, billId);
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return crow::response(500, "Failed to update bill");
-    }
-    sqlite3_finalize(stmt);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            return crow::response(500, "Failed to update bill");
+        }
 
-    crow::json::wvalue resp;
-    resp["message"] = "Bill updated successfully";
-    resp["billId"] = billId;
-    resp["totalFee"] = totalFee;
-    return crow::response(resp);
+        crow::json::wvalue resp;
+        resp["message"] = "Bill updated successfully";
+        resp["billId"] = billId;
+        resp["totalFee"] = totalFee;
+        return crow::response(resp);
+    });
 });
 
 
     // Example:
     // /ask_for_billing?billId=1
- CROW_ROUTE(app, "/ask_for_billing").methods(crow::HTTPMethod::GET)([&db](const crow::request& req) {
+ CROW_ROUTE(app, "/ask_for_billing").methods(crow::HTTPMethod::GET)([&writeQueue, &claimProcessor](const crow::request& req) {
     auto qs = req.url_params;
     const char* billIdStr = qs.get("billId");
 
@@ -842,57 +1594,34 @@ CROW_ROUTE(app, "/bills").methods(crow::HTTPMethod::GET)([&db]() {
         return crow::response(400, "Missing required parameter: billId");
     }
 
-    int billId = std::atoi(billIdStr);
-
-    // Verify if the bill exists and is insured
-    std::string query = "SELECT isInsured, claimed FROM Bills WHERE id = ?";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
-    }
-    sqlite3_bind_int(stmt, 1, billId);
-
-    bool isInsured = false, alreadyClaimed = false;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        isInsured = sqlite3_column_int(stmt, 0) != 0;
-        alreadyClaimed = sqlite3_column_int(stmt, 1) != 0;
-    } else {
-        sqlite3_finalize(stmt);
-        return crow::response(404, "Bill not found");
-    }
-    sqlite3_finalize(stmt);
-
-    if (!isInsured) {
-        return crow::response(400, "This bill is not for an insured patient");
-    }
-    if (alreadyClaimed) {
-        return crow::response(400, "This bill has already been claimed");
+    int billId;
+    if (!parseIntParam(billIdStr, billId)) {
+        return crow::response(400, "Invalid billId: expected an integer");
     }
 
-    // Update bill to mark it as claimed
-    query = "UPDATE Bills SET claimed = 1, claimStatus = 'Pending' WHERE id = ?";
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
-    }
-    sqlite3_bind_int(stmt, 1, billId);
+    crow::response res = runWrite(writeQueue, [&](DbConnection& conn) {
+        // Only an insured, unclaimed bill moves to Pending
+        ClaimResult result = submitClaim(conn, billId);
+        if (result != ClaimResult::Ok) {
+            return crow::response(claimResultStatus(result), claimResultMessage(result));
+        }
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return crow::response(500, "Failed to update claim status");
+        crow::json::wvalue resp;
+        resp["message"] = "Insurance claim submitted";
+        resp["billId"] = billId;
+        resp["claimStatus"] = "Pending";
+        return crow::response(resp);
+    });
+    if (res.code == 200 && claimProcessor) {
+        claimProcessor->kick();
     }
-    sqlite3_finalize(stmt);
-
-    crow::json::wvalue resp;
-    resp["message"] = "Insurance claim submitted";
-    resp["billId"] = billId;
-    resp["claimStatus"] = "Pending";
-    return crow::response(resp);
+    return res;
 });
 
 
         // Approve Claim
 // Example: /approve_insurance?billId=1
-CROW_ROUTE(app, "/approve_insurance").methods(crow::HTTPMethod::GET)([&db](const crow::request& req) {
+CROW_ROUTE(app, "/approve_insurance").methods(crow::HTTPMethod::GET)([&writeQueue](const crow::request& req) {
     auto qs = req.url_params;
     const char* billIdStr = qs.get("billId");
 
@@ -900,153 +1629,303 @@ CROW_ROUTE(app, "/approve_insurance").methods(crow::HTTPMethod::GET)([&db](const
         return crow::response(400, "Missing required parameter: billId");
     }
 
-    int billId = std::atoi(billIdStr);
-
-    // Verify if the bill exists and has a pending claim
-    std::string query = "SELECT claimStatus FROM Bills WHERE id = ?";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
+    int billId;
+    if (!parseIntParam(billIdStr, billId)) {
+        return crow::response(400, "Invalid billId: expected an integer");
     }
-    sqlite3_bind_int(stmt, 1, billId);
 
-    std::string claimStatus;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        claimStatus = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-    } else {
-        sqlite3_finalize(stmt);
-        return crow::response(404, "Bill not found");
-    }
-    sqlite3_finalize(stmt);
+    return runWrite(writeQueue, [&](DbConnection& conn) {
+        // Only a pending claim can be approved; one the insurer already settled is left alone
+        ClaimResult result = decideClaim(conn, billId, ClaimDecision::Approved);
+        if (result != ClaimResult::Ok) {
+            return crow::response(claimResultStatus(result), claimResultMessage(result));
+        }
 
-    if (claimStatus != "Pending") {
-        return crow::response(400, "Claim is not in a pending state");
+        crow::json::wvalue resp;
+        resp["message"] = "Claim approved successfully";
+        resp["billId"] = billId;
+        return crow::response(resp);
+    });
+});
+
+    // Bulk claim transitions: POST a JSON array (or NDJSON) of {"billId":N}. All bills are
+    // transitioned in one transaction; the response has one result per row, as for the other
+    // batch routes ("id" is the bill id).
+    // Example: POST /ask_for_billing/batch  [{"billId":1},{"billId":2}]
+    CROW_ROUTE(app, "/ask_for_billing/batch").methods(crow::HTTPMethod::POST)([&writeQueue, &claimProcessor](const crow::request& req) {
+    crow::response res = runBatch<long long>(writeQueue, req, parseClaimRow, submitClaimRow);
+    if (claimProcessor) {
+        claimProcessor->kick();
     }
+    return res;
+});
+
+    // Example: POST /approve_insurance/batch  [{"billId":1},{"billId":2}]
+    CROW_ROUTE(app, "/approve_insurance/batch").methods(crow::HTTPMethod::POST)([&writeQueue](const crow::request& req) {
+    return runBatch<long long>(writeQueue, req, parseClaimRow, approveClaimRow);
+});
+
 
-    // Update bill to mark it as approved
-    query = "UPDATE Bills SET claimStatus = 'Approved' WHERE id = ?";
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
+// Revenue and claim totals from the billing summaries; both dates are optional and inclusive
+// Example: /analytics/billing?from=2025-01-01&to=2025-01-31&doctorId=3
+CROW_ROUTE(app, "/analytics/billing").methods(crow::HTTPMethod::GET)([&pool, &billingAnalytics](const crow::request& req) {
+    auto qs = req.url_params;
+    const char* fromStr = qs.get("from");
+    const char* toStr = qs.get("to");
+    const char* doctorIdStr = qs.get("doctorId");
+
+    int from = fromStr ? dayKey(fromStr) : dayKey("0001-01-01");
+    int to = toStr ? dayKey(toStr) : dayKey("9999-12-31");
+    if (from == 0 || to == 0) {
+        return crow::response(400, "Invalid date. Expected a calendar date as YYYY-MM-DD");
+    }
+    if (from > to) {
+        return crow::response(400, "from must not be after to");
+    }
+    int doctorId = 0;
+    if (doctorIdStr && (!parseIntParam(doctorIdStr, doctorId) || doctorId <= 0)) {
+        return crow::response(400, "Invalid doctorId: expected a positive integer");
     }
-    sqlite3_bind_int(stmt, 1, billId);
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return crow::response(500, "Failed to update claim status");
+    std::shared_ptr<const BillingColumns> columns = billingAnalytics.columns(pool.local());
+    if (!columns) {
+        return crow::response(500, "Failed to load billing summaries");
     }
-    sqlite3_finalize(stmt);
 
-    crow::json::wvalue resp;
-    resp["message"] = "Claim approved successfully";
-    resp["billId"] = billId;
-    return crow::response(resp);
+    crow::response res(200);
+    res.set_header("Content-Type", "application/json");
+    StringSink sink(res.body);
+    JsonStreamWriter writer(sink);
+    writeBillingReport(writer, *columns, from, to, doctorId);
+    writer.finish();
+    return res;
 });
 
+// Full-text search over patients (name, medical history) and prescriptions (medication, instructions)
+// Example: /search?q=amox&type=prescriptions&limit=10
+CROW_ROUTE(app, "/search").methods(crow::HTTPMethod::GET)([&pool](const crow::request& req) {
+    return searchRecords(pool.local(), req.url_params);
+});
 
-CROW_ROUTE(app, "/inventory").methods(crow::HTTPMethod::GET)([&db]() {
-    std::string query = "SELECT * FROM Inventory";
-    sqlite3_stmt* stmt;
-    crow::json::wvalue resp;
-    std::vector<crow::json::wvalue> items;
-
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            crow::json::wvalue item;
-            item["id"] = sqlite3_column_int(stmt, 0);
-            item["itemName"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            item["quantity"] = sqlite3_column_int(stmt, 2);
-            items.push_back(std::move(item));
-        }
-        sqlite3_finalize(stmt);
+// Full table export, serialized row by row straight from SQLite (and compressed as it goes
+// when the client accepts gzip, deflate or zstd)
+// Example: /export/bills
+CROW_ROUTE(app, "/export/<string>").methods(crow::HTTPMethod::GET)([&pool](const crow::request& req, const std::string& table) {
+    const ListSpec* spec = listSpecByName(table);
+    if (!spec) {
+        return crow::response(404, "Unknown export: " + table);
+    }
+    return exportTable(pool.local(), *spec, negotiateFormat(req), negotiateEncoding(req));
+});
+
+// Notifications in id order, one page at a time; pass the last seen id as after_id
+// Example: /notifications?after_id=120&limit=50
+CROW_ROUTE(app, "/notifications").methods(crow::HTTPMethod::GET)([&pool, &notificationFeed](const crow::request& req) {
+    PageRequest page;
+    std::string error;
+    if (!parsePageRequest(req.url_params, page, error)) {
+        return crow::response(400, error);
+    }
+
+    std::vector<Notification> notifications;
+    bool hasMore = false;
+    if (!notificationFeed.readAfter(page.afterId, static_cast<size_t>(page.limit), notifications, hasMore)) {
+        // Older than the in-memory feed reaches back
+        return listPage(pool.local(), notificationListSpec(), req.url_params);
+    }
+
+    crow::response res(200);
+    res.set_header("Content-Type", "application/json");
+    StringSink sink(res.body);
+    JsonStreamWriter writer(sink);
+    writer.beginObject();
+    writer.key("notifications");
+    writer.beginArray();
+    for (const Notification& notification : notifications) {
+        writeNotification(writer, notification);
+    }
+    writer.endArray();
+    writer.key("nextCursor");
+    if (hasMore) {
+        writer.value(notifications.back().id);
     } else {
-        return crow::response(500, "Failed to fetch inventory");
+        writer.null();
     }
+    writer.endObject();
+    writer.finish();
+    return res;
+});
 
-    resp["inventory"] = std::move(items);
+// Live feed: every new notification is sent as one JSON text frame. Clients that reconnect
+// catch up with /notifications?after_id=<last id seen>.
+// Example: ws://localhost:8080/notifications/stream
+CROW_WEBSOCKET_ROUTE(app, "/notifications/stream")
+    .onopen([&notificationFeed](crow::websocket::connection& conn) {
+        notificationFeed.subscribe(&conn, [&conn](const std::string& frame) { conn.send_text(frame); });
+    })
+    .onclose([&notificationFeed](crow::websocket::connection& conn, auto&&...) {
+        notificationFeed.unsubscribe(&conn);
+    });
+
+// Prometheus text format: per-route request counts, latency quantiles, response bytes and
+// SQLite time/rows, plus writer, cache and notification feed counters
+// Example: /metrics
+CROW_ROUTE(app, "/metrics").methods(crow::HTTPMethod::GET)([&metrics, &pool, &writeQueue, &responseCache, &notificationFeed, &claimProcessor]() {
+    std::string out = metrics.render();
+    appendMetric(out, "healthcare_db_connections", "gauge", "Pooled SQLite connections.",
+                 static_cast<long long>(pool.size()));
+    appendMetric(out, "healthcare_write_queue_groups_total", "counter", "Write groups committed.",
+                 writeQueue.committedGroups());
+    appendMetric(out, "healthcare_write_queue_jobs_total", "counter", "Write jobs committed.",
+                 writeQueue.committedJobs());
+    appendMetric(out, "healthcare_patient_cache_hits_total", "counter", "Patient lookup cache hits.", patientCache.hits());
+    appendMetric(out, "healthcare_patient_cache_misses_total", "counter", "Patient lookup cache misses.", patientCache.misses());
+    appendMetric(out, "healthcare_doctor_cache_hits_total", "counter", "Doctor lookup cache hits.", doctorCache.hits());
+    appendMetric(out, "healthcare_doctor_cache_misses_total", "counter", "Doctor lookup cache misses.", doctorCache.misses());
+    appendMetric(out, "healthcare_response_cache_hits_total", "counter", "List response cache hits.", responseCache.hits());
+    appendMetric(out, "healthcare_response_cache_misses_total", "counter", "List response cache misses.", responseCache.misses());
+    appendMetric(out, "healthcare_notification_subscribers", "gauge", "Open notification WebSocket streams.",
+                 static_cast<long long>(notificationFeed.subscriberCount()));
+    appendMetric(out, "healthcare_claims_approved_total", "counter", "Claims approved by the insurer.",
+                 claimProcessor ? claimProcessor->approved() : 0);
+    appendMetric(out, "healthcare_claims_rejected_total", "counter", "Claims rejected by the insurer.",
+                 claimProcessor ? claimProcessor->rejected() : 0);
+    appendMetric(out, "healthcare_claims_conflicts_total", "counter",
+                 "Insurer decisions dropped because the claim had already left Pending.",
+                 claimProcessor ? claimProcessor->conflicts() : 0);
+
+    crow::response res(200);
+    res.set_header("Content-Type", "text/plain; version=0.0.4");
+    res.body = std::move(out);
+    return res;
+});
+
+// Hit/miss counters of the patient and doctor lookup caches and the list response cache
+// Example: /cache_stats
+CROW_ROUTE(app, "/cache_stats").methods(crow::HTTPMethod::GET)([&responseCache]() {
+    crow::json::wvalue resp;
+    resp["patients"]["hits"] = patientCache.hits();
+    resp["patients"]["misses"] = patientCache.misses();
+    resp["patients"]["entries"] = patientCache.size();
+    resp["doctors"]["hits"] = doctorCache.hits();
+    resp["doctors"]["misses"] = doctorCache.misses();
+    resp["doctors"]["entries"] = doctorCache.size();
+    resp["responses"]["hits"] = responseCache.hits();
+    resp["responses"]["misses"] = responseCache.misses();
     return crow::response(resp);
 });
 
-CROW_ROUTE(app, "/update_inventory_item").methods(crow::HTTPMethod::GET)([&db](const crow::request& req) {
+// Example: /inventory?limit=100&after_id=0
+CROW_ROUTE(app, "/inventory").methods(crow::HTTPMethod::GET)([&pool, &responseCache](const crow::request& req) {
+    const ListSpec& spec = inventoryListSpec();
+    BodyFormat format = negotiateFormat(req);
+    return responseCache.serve(
+        req, spec.table, [&] { return listPage(pool.local(), spec, req.url_params, format); }, formatName(format));
+});
+
+CROW_ROUTE(app, "/update_inventory_item").methods(crow::HTTPMethod::GET)([&writeQueue](const crow::request& req) {
     auto qs = req.url_params;
     const char* itemName = qs.get("itemName");
     const char* quantityStr = qs.get("quantity");
+    const char* deltaStr = qs.get("delta");
 
-    if (!itemName || !quantityStr) {
-        return crow::response(400, "Missing 'itemName' or 'quantity'");
+    // 'quantity' sets the stock level, 'delta' adds to (or, when negative, takes from) it
+    if (!itemName || (!quantityStr == !deltaStr)) {
+        return crow::response(400, "Missing 'itemName' or exactly one of 'quantity' and 'delta'");
     }
 
-    int newQuantity = std::atoi(quantityStr);
-    if (newQuantity < 0) {
-        return crow::response(400, "Quantity cannot be negative");
-    }
+    long long amount;
+    if (quantityStr) {
+        int quantity;
+        if (!parseIntParam(quantityStr, quantity)) {
+            return crow::response(400, "Invalid 'quantity': expected an integer");
+        }
+        if (quantity < 0) {
+            return crow::response(400, "Quantity cannot be negative");
+        }
+        amount = quantity;
+    } else {
+        int delta;
+        if (!parseIntParam(deltaStr, delta)) {
+            return crow::response(400, "Invalid 'delta': expected an integer");
+        }
+        amount = delta;
+    }
+
+    return runWrite(writeQueue, [&](DbConnection& conn) {
+        long long newQuantity = 0;
+        StockResult result = quantityStr ? setStock(conn, itemName, amount, newQuantity)
+                                         : adjustStock(conn, itemName, amount, newQuantity);
+        switch (result) {
+        case StockResult::Ok:
+            break;
+        case StockResult::UnknownItem:
+            return crow::response(404, "Inventory item not found");
+        case StockResult::InsufficientStock:
+            return crow::response(409, "Not enough stock for this adjustment");
+        case StockResult::Failed:
+            return crow::response(500, "Failed to update inventory");
+        }
 
-    bool isUpdated = false;
-    sqlite3_stmt* stmt;
+        crow::json::wvalue resp;
+        resp["message"] = "Inventory updated successfully";
+        resp["itemName"] = itemName;
+        resp["quantity"] = newQuantity;
 
-    // Check if the item exists
-    std::string query = "SELECT quantity FROM Inventory WHERE itemName = ?";
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Failed to prepare statement");
-    }
-    sqlite3_bind_text(stmt, 1, itemName, -1, SQLITE_STATIC);
+        return crow::response(resp);
+    });
+});
+
+// Takes the prescribed medication out of stock
+CROW_ROUTE(app, "/dispense_prescription").methods(crow::HTTPMethod::GET)([&writeQueue](const crow::request& req) {
+    auto qs = req.url_params;
+    const char* prescriptionIdStr = qs.get("prescriptionId");
+    const char* quantityStr = qs.get("quantity");
 
-    bool exists = false;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        exists = true;
+    if (!prescriptionIdStr || !quantityStr) {
+        return crow::response(400, "Missing 'prescriptionId' or 'quantity'");
     }
-    sqlite3_finalize(stmt);
 
-    if (exists) {
-        // Update the existing item
-        query = "UPDATE Inventory SET quantity = ? WHERE itemName = ?";
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Failed to prepare statement");
-        }
-        sqlite3_bind_int(stmt, 1, newQuantity);
-        sqlite3_bind_text(stmt, 2, itemName, -1, SQLITE_STATIC);
+    long long prescriptionId;
+    int quantity;
+    if (!parseInt64Param(prescriptionIdStr, prescriptionId)) {
+        return crow::response(400, "Invalid 'prescriptionId': expected an integer");
+    }
+    if (!parseIntParam(quantityStr, quantity) || quantity <= 0) {
+        return crow::response(400, "Invalid 'quantity': expected a positive integer");
+    }
 
-        if (sqlite3_step(stmt) == SQLITE_DONE) {
-            isUpdated = true;
-        }
-        sqlite3_finalize(stmt);
-    } else {
-        // Add the new item
-        query = "INSERT INTO Inventory (itemName, quantity) VALUES (?, ?)";
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    return runWrite(writeQueue, [&](DbConnection& conn) {
+        CachedStatement stmt = conn.prepare("SELECT medication FROM Prescriptions WHERE prescriptionId = ?");
+        if (!stmt) {
             return crow::response(500, "Failed to prepare statement");
         }
-        sqlite3_bind_text(stmt, 1, itemName, -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 2, newQuantity);
-
-        if (sqlite3_step(stmt) == SQLITE_DONE) {
-            isUpdated = true;
-        }
-        sqlite3_finalize(stmt);
-    }
-
-    // Generate a low-stock notification if quantity < 10
-    if (newQuantity < 10) {
-        query = "INSERT INTO Notifications (itemName, message) VALUES (?, ?)";
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            return crow::response(500, "Failed to prepare notification statement");
+        sqlite3_bind_int64(stmt, 1, prescriptionId);
+        if (sqlite3_step(stmt) != SQLITE_ROW) {
+            return crow::response(404, "Prescription not found");
         }
-        std::string message = "Low stock warning: " + std::string(itemName) + " has only " + std::to_string(newQuantity) + " items left. Please add stock ";
-        sqlite3_bind_text(stmt, 1, itemName, -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, message.c_str(), -1, SQLITE_STATIC);
-
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            return crow::response(500, "Failed to insert notification");
+        std::string medication = columnText(stmt, 0);
+
+        long long remaining = 0;
+        switch (adjustStock(conn, medication, -static_cast<long long>(quantity), remaining)) {
+        case StockResult::Ok:
+            break;
+        case StockResult::UnknownItem:
+            return crow::response(404, "Medication is not stocked");
+        case StockResult::InsufficientStock:
+            return crow::response(409, "Not enough stock to dispense this prescription");
+        case StockResult::Failed:
+            return crow::response(500, "Failed to update inventory");
         }
-        sqlite3_finalize(stmt);
-    }
 
-    crow::json::wvalue resp;
-    resp["message"] = "Inventory updated successfully";
-    resp["itemName"] = itemName;
-    resp["quantity"] = newQuantity;
+        crow::json::wvalue resp;
+        resp["message"] = "Prescription dispensed";
+        resp["prescriptionId"] = prescriptionId;
+        resp["itemName"] = medication;
+        resp["quantity"] = remaining;
 
-    return crow::response(resp);
+        return crow::response(resp);
+    });
 });
 
 
@@ -1056,6 +1935,11 @@ CROW_ROUTE(app, "/update_inventory_item").methods(crow::HTTPMethod::GET)([&db](c
 
     // Start server on port 8080
     app.port(8080).multithreaded().run();
-    sqlite3_close(db);
+    lowStockEvaluator.stop();
+    if (claimProcessor) {
+        claimProcessor->stop();
+    }
+    writeQueue.stop();
+    checkpointer.stop();
     return 0;
 }
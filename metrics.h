@@ -0,0 +1,358 @@
+#pragma once
+#include "crow.h"
+#include <sqlite3.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "database.h"
+#include "latency_histogram.h"
+#include "write_queue.h"
+
+// ------------------ Request Metrics ------------------
+// Per-route counters recorded by RequestMetrics (a Crow middleware) around every handler.
+// SQLite work is attributed to the route whose handler runs it: connections are traced with
+// sqlite3_trace_v2, and the handler's route is kept in a thread-local that runWrite() carries
+// over to the writer thread. Work outside any request (group commits, background workers)
+// is counted under the "background" route.
+
+struct RouteMetrics {
+    explicit RouteMetrics(std::string label) : label(std::move(label)) {}
+
+    const std::string label;
+    std::array<std::atomic<uint64_t>, 5> statusClasses{};  // 1xx..5xx
+    LatencyHistogram latencyUs;
+    std::atomic<uint64_t> responseBytes{0};
+    std::atomic<uint64_t> sqliteStatements{0};
+    std::atomic<uint64_t> sqliteStatementNs{0};
+    std::atomic<uint64_t> sqlitePrepareNs{0};
+    std::atomic<uint64_t> sqliteRows{0};
+    std::atomic<uint64_t> writeWaitNs{0};
+};
+
+// Makes `route` the current route of this thread for its lifetime
+class RouteScope {
+public:
+    explicit RouteScope(RouteMetrics* route) : previous_(current()) { current() = route; }
+    ~RouteScope() { current() = previous_; }
+
+    RouteScope(const RouteScope&) = delete;
+    RouteScope& operator=(const RouteScope&) = delete;
+
+    static RouteMetrics*& current() {
+        thread_local RouteMetrics* route = nullptr;
+        return route;
+    }
+
+private:
+    RouteMetrics* previous_;
+};
+
+// Runs `work` on the writer on behalf of the current request and waits for its group to
+// commit. The job's SQLite time and the wait are both counted under the request's route.
+template <typename Work>
+bool commitForRoute(WriteQueue& queue, Work work) {
+    RouteMetrics* route = RouteScope::current();
+    auto start = std::chrono::steady_clock::now();
+    bool committed = queue.submit([&](DbConnection& conn) {
+        RouteScope scope(route);
+        return work(conn);
+    }).get();
+    if (route) {
+        auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        route->writeWaitNs.fetch_add(static_cast<uint64_t>(waited.count()), std::memory_order_relaxed);
+    }
+    return committed;
+}
+
+inline void appendNumber(std::string& out, uint64_t value) { out += std::to_string(value); }
+inline void appendNumber(std::string& out, long long value) { out += std::to_string(value); }
+inline void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    int size = std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    out.append(buffer, static_cast<size_t>(size));
+}
+
+// Appends one sample in the Prometheus text format, with its HELP/TYPE header
+template <typename Number>
+void appendMetric(std::string& out, const char* name, const char* type, const char* help, Number value) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+    out += name;
+    out += ' ';
+    appendNumber(out, value);
+    out += '\n';
+}
+
+class RequestMetrics {
+public:
+    struct context {
+        std::chrono::steady_clock::time_point start;
+        RouteMetrics* route = nullptr;
+    };
+
+    // Distinct route labels kept; further unknown paths share the "other" label
+    static constexpr size_t kMaxRoutes = 256;
+
+    RequestMetrics() : background_(std::make_unique<RouteMetrics>("background")) {}
+
+    void before_handle(crow::request& req, crow::response&, context& ctx) {
+        inFlight_.fetch_add(1, std::memory_order_relaxed);
+        ctx.route = route(std::string(crow::method_name(req.method)) + ' ' + normalizePath(req.url));
+        RouteScope::current() = ctx.route;
+        ctx.start = std::chrono::steady_clock::now();
+    }
+
+    void after_handle(crow::request&, crow::response& res, context& ctx) {
+        auto elapsed = std::chrono::steady_clock::now() - ctx.start;
+        if (RouteScope::current() == ctx.route) {
+            RouteScope::current() = nullptr;
+        }
+        RouteMetrics& route = *ctx.route;
+        route.latencyUs.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+        int statusClass = res.code / 100;
+        if (statusClass >= 1 && statusClass <= 5) {
+            route.statusClasses[statusClass - 1].fetch_add(1, std::memory_order_relaxed);
+        }
+        route.responseBytes.fetch_add(res.body.size(), std::memory_order_relaxed);
+        inFlight_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Route of the request being handled on this thread, or nullptr
+    static RouteMetrics* currentRoute() { return RouteScope::current(); }
+
+    // Installs statement tracing and prepare timing on a connection; call before first use
+    void instrument(DbConnection& conn) {
+        sqlite3_trace_v2(conn.handle(), SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW,
+                         &RequestMetrics::onTrace, this);
+        conn.onPrepare([this](std::chrono::nanoseconds elapsed) {
+            target().sqlitePrepareNs.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+        });
+    }
+
+    // All metrics in the Prometheus text exposition format
+    std::string render() const {
+        std::vector<const RouteMetrics*> routes;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            routes.reserve(routes_.size() + 1);
+            for (const auto& entry : routes_) {
+                routes.push_back(entry.second.get());
+            }
+        }
+        routes.push_back(background_.get());
+
+        std::string out;
+        out.reserve(256 * routes.size() + 4096);
+        appendMetric(out, "healthcare_http_requests_in_flight", "gauge", "Requests currently being handled.",
+                     inFlight_.load(std::memory_order_relaxed));
+
+        header(out, "healthcare_http_requests_total", "counter", "Requests handled, by route and status class.");
+        static const char* const classes[] = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+        for (const RouteMetrics* route : routes) {
+            for (size_t i = 0; i < route->statusClasses.size(); ++i) {
+                uint64_t count = route->statusClasses[i].load(std::memory_order_relaxed);
+                if (count > 0) {
+                    sample(out, "healthcare_http_requests_total", route->label, "code", classes[i], count);
+                }
+            }
+        }
+
+        header(out, "healthcare_http_request_duration_seconds", "summary",
+               "Request latency from middleware entry to exit, since startup.");
+        static const char* const quantiles[] = {"0.5", "0.9", "0.99", "0.999"};
+        static const double quantileValues[] = {0.5, 0.9, 0.99, 0.999};
+        for (const RouteMetrics* route : routes) {
+            LatencyHistogram::Snapshot snap = route->latencyUs.snapshot();
+            if (snap.count == 0) {
+                continue;
+            }
+            for (size_t i = 0; i < 4; ++i) {
+                sample(out, "healthcare_http_request_duration_seconds", route->label, "quantile", quantiles[i],
+                       seconds(snap.quantile(quantileValues[i]) * 1000));
+            }
+            sample(out, "healthcare_http_request_duration_seconds_sum", route->label, nullptr, nullptr,
+                   seconds(snap.sum * 1000));
+            sample(out, "healthcare_http_request_duration_seconds_count", route->label, nullptr, nullptr, snap.count);
+        }
+
+        counter(out, routes, "healthcare_http_response_bytes_total", "Response body bytes as sent, after compression.",
+                &RouteMetrics::responseBytes, false);
+        counter(out, routes, "healthcare_sqlite_statements_total", "SQLite statements run to completion or reset.",
+                &RouteMetrics::sqliteStatements, false);
+        counter(out, routes, "healthcare_sqlite_rows_total", "Rows returned by SQLite statements.",
+                &RouteMetrics::sqliteRows, false);
+        counter(out, routes, "healthcare_sqlite_statement_seconds_total",
+                "Time from each statement's first step to its completion or reset.", &RouteMetrics::sqliteStatementNs, true);
+        counter(out, routes, "healthcare_sqlite_prepare_seconds_total",
+                "Time spent compiling statements (statement cache misses).", &RouteMetrics::sqlitePrepareNs, true);
+        counter(out, routes, "healthcare_write_queue_wait_seconds_total",
+                "Time handlers waited for the writer to run and commit their jobs.", &RouteMetrics::writeWaitNs, true);
+        return out;
+    }
+
+private:
+    // Request paths with numeric segments collapsed, so /patients/42/timeline and
+    // /patients/7/timeline share the label /patients/<int>/timeline
+    static std::string normalizePath(std::string_view path) {
+        std::string label;
+        label.reserve(path.size());
+        while (!path.empty()) {
+            size_t slash = path.find('/', 1);
+            std::string_view segment = path.substr(0, slash);
+            path = slash == std::string_view::npos ? std::string_view() : path.substr(slash);
+            bool numeric = segment.size() > 1;
+            for (size_t i = 1; i < segment.size() && numeric; ++i) {
+                numeric = segment[i] >= '0' && segment[i] <= '9';
+            }
+            if (numeric) {
+                label += "/<int>";
+            } else {
+                label.append(segment.data(), segment.size());
+            }
+        }
+        return label.empty() ? "/" : label;
+    }
+
+    RouteMetrics* route(const std::string& label) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = routes_.find(label);
+            if (it != routes_.end()) {
+                return it->second.get();
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        const std::string& key = routes_.size() < kMaxRoutes || routes_.count(label) ? label : otherLabel();
+        auto& slot = routes_[key];
+        if (!slot) {
+            slot = std::make_unique<RouteMetrics>(key);
+        }
+        return slot.get();
+    }
+
+    static const std::string& otherLabel() {
+        static const std::string label = "other";
+        return label;
+    }
+
+    RouteMetrics& target() const {
+        RouteMetrics* route = RouteScope::current();
+        return route ? *route : *background_;
+    }
+
+    // SQLite's own SQLITE_TRACE_PROFILE timing has millisecond resolution, so statements are
+    // timed here from their first step (SQLITE_TRACE_STMT) to completion or reset
+    static int onTrace(unsigned type, void* self, void* subject, void*) {
+        thread_local std::vector<std::pair<void*, std::chrono::steady_clock::time_point>> running;
+        if (type == SQLITE_TRACE_STMT) {
+            // Also reported for each trigger the statement fires; keep the first start time
+            for (const auto& entry : running) {
+                if (entry.first == subject) {
+                    return 0;
+                }
+            }
+            running.emplace_back(subject, std::chrono::steady_clock::now());
+            return 0;
+        }
+        RouteMetrics& route = static_cast<RequestMetrics*>(self)->target();
+        if (type == SQLITE_TRACE_ROW) {
+            route.sqliteRows.fetch_add(1, std::memory_order_relaxed);
+        } else if (type == SQLITE_TRACE_PROFILE) {
+            route.sqliteStatements.fetch_add(1, std::memory_order_relaxed);
+            for (size_t i = 0; i < running.size(); ++i) {
+                if (running[i].first == subject) {
+                    auto elapsed = std::chrono::steady_clock::now() - running[i].second;
+                    route.sqliteStatementNs.fetch_add(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+                        std::memory_order_relaxed);
+                    running[i] = running.back();
+                    running.pop_back();
+                    break;
+                }
+            }
+        }
+        return 0;
+    }
+
+    static double seconds(uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1e9; }
+
+    static void header(std::string& out, const char* name, const char* type, const char* help) {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+
+    // name{route="...",key="value"} number
+    template <typename Number>
+    static void sample(std::string& out, const char* name, const std::string& route, const char* key,
+                       const char* value, Number number) {
+        out += name;
+        out += "{route=\"";
+        for (char c : route) {
+            if (c == '\\' || c == '"') {
+                out += '\\';
+                out += c;
+            } else if (c == '\n') {
+                out += "\\n";
+            } else {
+                out += c;
+            }
+        }
+        out += '"';
+        if (key) {
+            out += ',';
+            out += key;
+            out += "=\"";
+            out += value;
+            out += '"';
+        }
+        out += "} ";
+        appendNumber(out, number);
+        out += '\n';
+    }
+
+    static void counter(std::string& out, const std::vector<const RouteMetrics*>& routes, const char* name,
+                        const char* help, std::atomic<uint64_t> RouteMetrics::*field, bool nanoseconds) {
+        header(out, name, "counter", help);
+        for (const RouteMetrics* route : routes) {
+            uint64_t value = (route->*field).load(std::memory_order_relaxed);
+            if (value == 0) {
+                continue;
+            }
+            if (nanoseconds) {
+                sample(out, name, route->label, nullptr, nullptr, seconds(value));
+            } else {
+                sample(out, name, route->label, nullptr, nullptr, value);
+            }
+        }
+    }
+
+    std::unique_ptr<RouteMetrics> background_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<RouteMetrics>> routes_;
+    std::atomic<long long> inFlight_{0};
+};
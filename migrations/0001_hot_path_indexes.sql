@@ -0,0 +1,18 @@
+-- Secondary indexes for the hot lookup paths.
+
+-- Inventory is keyed by item name; collapse duplicates left by the old racy SELECT-then-INSERT
+-- so the unique index can be built. The oldest row of each name is kept with its own quantity:
+-- /update_inventory_item set the same absolute stock on every row of a name, so the duplicates
+-- are copies of one stock level, not separate stock to add up.
+DELETE FROM Inventory WHERE id NOT IN (SELECT MIN(id) FROM Inventory GROUP BY itemName);
+CREATE UNIQUE INDEX IF NOT EXISTS idx_inventory_item_name ON Inventory(itemName);
+
+-- One appointment per doctor per slot. Also serves per-doctor and per-doctor-per-day lookups.
+-- Existing double bookings are reported before this script runs (migrationChecks() in
+-- database.h) and have to be resolved by hand.
+CREATE UNIQUE INDEX IF NOT EXISTS idx_appointments_doctor_slot ON Appointments(doctorId, date, time);
+
+CREATE INDEX IF NOT EXISTS idx_bills_patient ON Bills(patientId);
+CREATE INDEX IF NOT EXISTS idx_bills_claim_status ON Bills(claimStatus);
+CREATE INDEX IF NOT EXISTS idx_prescriptions_patient ON Prescriptions(patientId);
+CREATE INDEX IF NOT EXISTS idx_notifications_timestamp ON Notifications(timestamp);
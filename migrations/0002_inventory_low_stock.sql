@@ -0,0 +1,9 @@
+-- Low-stock alerts are raised once per item by the background evaluator (see inventory.h)
+-- and re-armed when the item is restocked to the threshold or above.
+ALTER TABLE Inventory ADD COLUMN lowStockNotified INTEGER NOT NULL DEFAULT 0 CHECK (lowStockNotified IN (0, 1));
+
+-- Items that are already low were warned about by the old per-update notification inserts
+UPDATE Inventory SET lowStockNotified = 1 WHERE quantity < 10;
+
+-- The evaluator only visits items whose alert state has to flip
+CREATE INDEX IF NOT EXISTS idx_inventory_low_stock ON Inventory(lowStockNotified, quantity);
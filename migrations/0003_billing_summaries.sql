@@ -0,0 +1,105 @@
+-- Billing analytics read these summaries instead of scanning Bills (see billing_analytics.h).
+-- Triggers keep them in step with every write to Bills, whichever route or worker makes it.
+
+-- Fees per doctor and appointment day
+CREATE TABLE IF NOT EXISTS BillingDaily (
+    date TEXT NOT NULL,
+    doctorId INTEGER NOT NULL,
+    bills INTEGER NOT NULL DEFAULT 0,
+    medicationFee REAL NOT NULL DEFAULT 0.0,
+    consultationFee REAL NOT NULL DEFAULT 0.0,
+    surgeryFee REAL NOT NULL DEFAULT 0.0,
+    totalFee REAL NOT NULL DEFAULT 0.0,
+    PRIMARY KEY (date, doctorId)
+) WITHOUT ROWID;
+
+-- Insured bills per insurer and claim status
+CREATE TABLE IF NOT EXISTS ClaimSummary (
+    insuranceCompany TEXT NOT NULL,
+    claimStatus TEXT NOT NULL,
+    claims INTEGER NOT NULL DEFAULT 0,
+    amount REAL NOT NULL DEFAULT 0.0,
+    PRIMARY KEY (insuranceCompany, claimStatus)
+) WITHOUT ROWID;
+
+INSERT INTO BillingDaily (date, doctorId, bills, medicationFee, consultationFee, surgeryFee, totalFee)
+SELECT a.date, a.doctorId, count(*), total(b.medicationFee), total(b.consultationFee), total(b.surgeryFee), total(b.totalFee)
+FROM Bills b JOIN Appointments a ON a.id = b.appointmentId
+GROUP BY a.date, a.doctorId;
+
+INSERT INTO ClaimSummary (insuranceCompany, claimStatus, claims, amount)
+SELECT COALESCE(insuranceCompany, ''), COALESCE(claimStatus, 'Not Submitted'), count(*), total(totalFee)
+FROM Bills WHERE isInsured = 1
+GROUP BY 1, 2;
+
+CREATE TRIGGER IF NOT EXISTS bills_summary_insert AFTER INSERT ON Bills BEGIN
+    INSERT INTO BillingDaily (date, doctorId, bills, medicationFee, consultationFee, surgeryFee, totalFee)
+    SELECT a.date, a.doctorId, 1, COALESCE(NEW.medicationFee, 0), COALESCE(NEW.consultationFee, 0),
+           COALESCE(NEW.surgeryFee, 0), COALESCE(NEW.totalFee, 0)
+    FROM Appointments a WHERE a.id = NEW.appointmentId
+    ON CONFLICT (date, doctorId) DO UPDATE SET
+        bills = bills + 1,
+        medicationFee = medicationFee + excluded.medicationFee,
+        consultationFee = consultationFee + excluded.consultationFee,
+        surgeryFee = surgeryFee + excluded.surgeryFee,
+        totalFee = totalFee + excluded.totalFee;
+
+    INSERT INTO ClaimSummary (insuranceCompany, claimStatus, claims, amount)
+    SELECT COALESCE(NEW.insuranceCompany, ''), COALESCE(NEW.claimStatus, 'Not Submitted'), 1, COALESCE(NEW.totalFee, 0)
+    WHERE NEW.isInsured = 1
+    ON CONFLICT (insuranceCompany, claimStatus) DO UPDATE SET
+        claims = claims + 1,
+        amount = amount + excluded.amount;
+END;
+
+CREATE TRIGGER IF NOT EXISTS bills_summary_delete AFTER DELETE ON Bills BEGIN
+    UPDATE BillingDaily SET
+        bills = bills - 1,
+        medicationFee = medicationFee - COALESCE(OLD.medicationFee, 0),
+        consultationFee = consultationFee - COALESCE(OLD.consultationFee, 0),
+        surgeryFee = surgeryFee - COALESCE(OLD.surgeryFee, 0),
+        totalFee = totalFee - COALESCE(OLD.totalFee, 0)
+    WHERE (date, doctorId) = (SELECT date, doctorId FROM Appointments WHERE id = OLD.appointmentId);
+
+    UPDATE ClaimSummary SET claims = claims - 1, amount = amount - COALESCE(OLD.totalFee, 0)
+    WHERE OLD.isInsured = 1 AND insuranceCompany = COALESCE(OLD.insuranceCompany, '')
+      AND claimStatus = COALESCE(OLD.claimStatus, 'Not Submitted');
+END;
+
+-- Fee edits (/update_bill) move the bill's amounts; the day and doctor only change with the appointment
+CREATE TRIGGER IF NOT EXISTS bills_summary_fees
+AFTER UPDATE OF appointmentId, medicationFee, consultationFee, surgeryFee, totalFee ON Bills BEGIN
+    UPDATE BillingDaily SET
+        bills = bills - 1,
+        medicationFee = medicationFee - COALESCE(OLD.medicationFee, 0),
+        consultationFee = consultationFee - COALESCE(OLD.consultationFee, 0),
+        surgeryFee = surgeryFee - COALESCE(OLD.surgeryFee, 0),
+        totalFee = totalFee - COALESCE(OLD.totalFee, 0)
+    WHERE (date, doctorId) = (SELECT date, doctorId FROM Appointments WHERE id = OLD.appointmentId);
+
+    INSERT INTO BillingDaily (date, doctorId, bills, medicationFee, consultationFee, surgeryFee, totalFee)
+    SELECT a.date, a.doctorId, 1, COALESCE(NEW.medicationFee, 0), COALESCE(NEW.consultationFee, 0),
+           COALESCE(NEW.surgeryFee, 0), COALESCE(NEW.totalFee, 0)
+    FROM Appointments a WHERE a.id = NEW.appointmentId
+    ON CONFLICT (date, doctorId) DO UPDATE SET
+        bills = bills + 1,
+        medicationFee = medicationFee + excluded.medicationFee,
+        consultationFee = consultationFee + excluded.consultationFee,
+        surgeryFee = surgeryFee + excluded.surgeryFee,
+        totalFee = totalFee + excluded.totalFee;
+END;
+
+-- Claim transitions (/ask_for_billing, /approve_insurance, the claim processor) and fee edits
+CREATE TRIGGER IF NOT EXISTS bills_summary_claims
+AFTER UPDATE OF isInsured, insuranceCompany, claimStatus, totalFee ON Bills BEGIN
+    UPDATE ClaimSummary SET claims = claims - 1, amount = amount - COALESCE(OLD.totalFee, 0)
+    WHERE OLD.isInsured = 1 AND insuranceCompany = COALESCE(OLD.insuranceCompany, '')
+      AND claimStatus = COALESCE(OLD.claimStatus, 'Not Submitted');
+
+    INSERT INTO ClaimSummary (insuranceCompany, claimStatus, claims, amount)
+    SELECT COALESCE(NEW.insuranceCompany, ''), COALESCE(NEW.claimStatus, 'Not Submitted'), 1, COALESCE(NEW.totalFee, 0)
+    WHERE NEW.isInsured = 1
+    ON CONFLICT (insuranceCompany, claimStatus) DO UPDATE SET
+        claims = claims + 1,
+        amount = amount + excluded.amount;
+END;
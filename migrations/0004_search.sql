@@ -0,0 +1,56 @@
+-- Full-text indexes for /search (see search.h). External-content FTS5 tables: the text stays in
+-- Patients and Prescriptions and only the inverted index is stored here. Prefix indexes of 2 and
+-- 3 characters make type-ahead queries ("amox*") index lookups instead of term scans.
+
+CREATE VIRTUAL TABLE IF NOT EXISTS PatientSearch USING fts5(
+    name, medicalHistory,
+    content = 'Patients', content_rowid = 'id',
+    prefix = '2 3', tokenize = 'unicode61 remove_diacritics 2'
+);
+
+CREATE VIRTUAL TABLE IF NOT EXISTS PrescriptionSearch USING fts5(
+    medication, instructions,
+    content = 'Prescriptions', content_rowid = 'prescriptionId',
+    prefix = '2 3', tokenize = 'unicode61 remove_diacritics 2'
+);
+
+-- Default ranking: a hit in the name or medication counts ten times one in the free text
+INSERT INTO PatientSearch (PatientSearch, rank) VALUES ('rank', 'bm25(10.0, 1.0)');
+INSERT INTO PrescriptionSearch (PrescriptionSearch, rank) VALUES ('rank', 'bm25(10.0, 1.0)');
+
+INSERT INTO PatientSearch (PatientSearch) VALUES ('rebuild');
+INSERT INTO PrescriptionSearch (PrescriptionSearch) VALUES ('rebuild');
+
+-- An external-content index has to be told the old text of a row to remove it
+CREATE TRIGGER IF NOT EXISTS patients_search_insert AFTER INSERT ON Patients BEGIN
+    INSERT INTO PatientSearch (rowid, name, medicalHistory) VALUES (NEW.id, NEW.name, NEW.medicalHistory);
+END;
+
+CREATE TRIGGER IF NOT EXISTS patients_search_delete AFTER DELETE ON Patients BEGIN
+    INSERT INTO PatientSearch (PatientSearch, rowid, name, medicalHistory)
+    VALUES ('delete', OLD.id, OLD.name, OLD.medicalHistory);
+END;
+
+CREATE TRIGGER IF NOT EXISTS patients_search_update AFTER UPDATE OF id, name, medicalHistory ON Patients BEGIN
+    INSERT INTO PatientSearch (PatientSearch, rowid, name, medicalHistory)
+    VALUES ('delete', OLD.id, OLD.name, OLD.medicalHistory);
+    INSERT INTO PatientSearch (rowid, name, medicalHistory) VALUES (NEW.id, NEW.name, NEW.medicalHistory);
+END;
+
+CREATE TRIGGER IF NOT EXISTS prescriptions_search_insert AFTER INSERT ON Prescriptions BEGIN
+    INSERT INTO PrescriptionSearch (rowid, medication, instructions)
+    VALUES (NEW.prescriptionId, NEW.medication, NEW.instructions);
+END;
+
+CREATE TRIGGER IF NOT EXISTS prescriptions_search_delete AFTER DELETE ON Prescriptions BEGIN
+    INSERT INTO PrescriptionSearch (PrescriptionSearch, rowid, medication, instructions)
+    VALUES ('delete', OLD.prescriptionId, OLD.medication, OLD.instructions);
+END;
+
+CREATE TRIGGER IF NOT EXISTS prescriptions_search_update
+AFTER UPDATE OF prescriptionId, medication, instructions ON Prescriptions BEGIN
+    INSERT INTO PrescriptionSearch (PrescriptionSearch, rowid, medication, instructions)
+    VALUES ('delete', OLD.prescriptionId, OLD.medication, OLD.instructions);
+    INSERT INTO PrescriptionSearch (rowid, medication, instructions)
+    VALUES (NEW.prescriptionId, NEW.medication, NEW.instructions);
+END;
@@ -0,0 +1,18 @@
+-- Medical records move into SQLite so a patient's chart is one set of indexed lookups
+-- (see timeline.h). Every per-patient index is ordered by date, so each part of the timeline
+-- comes back already sorted.
+CREATE TABLE IF NOT EXISTS MedicalRecords (
+    recordId INTEGER PRIMARY KEY AUTOINCREMENT,
+    patientId INTEGER NOT NULL,
+    visitDate TEXT NOT NULL,
+    notes TEXT,
+    diagnosis TEXT,
+    FOREIGN KEY (patientId) REFERENCES Patients(id)
+);
+
+CREATE INDEX IF NOT EXISTS idx_medical_records_patient ON MedicalRecords(patientId, visitDate);
+CREATE INDEX IF NOT EXISTS idx_appointments_patient ON Appointments(patientId, date, time);
+
+-- Also serves the plain patientId lookups of the index it replaces
+CREATE INDEX IF NOT EXISTS idx_prescriptions_patient_date ON Prescriptions(patientId, datePrescribed);
+DROP INDEX IF EXISTS idx_prescriptions_patient;
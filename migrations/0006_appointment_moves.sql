@@ -0,0 +1,25 @@
+-- Rescheduling an appointment (PUT/PATCH /appointments/<id>) moves its bills' amounts to the
+-- new day and doctor in BillingDaily (see 0003_billing_summaries.sql).
+
+CREATE TRIGGER IF NOT EXISTS appointments_summary_move
+AFTER UPDATE OF doctorId, date ON Appointments
+WHEN OLD.doctorId IS NOT NEW.doctorId OR OLD.date IS NOT NEW.date BEGIN
+    UPDATE BillingDaily SET
+        bills = bills - (SELECT count(*) FROM Bills WHERE appointmentId = NEW.id),
+        medicationFee = medicationFee - (SELECT total(medicationFee) FROM Bills WHERE appointmentId = NEW.id),
+        consultationFee = consultationFee - (SELECT total(consultationFee) FROM Bills WHERE appointmentId = NEW.id),
+        surgeryFee = surgeryFee - (SELECT total(surgeryFee) FROM Bills WHERE appointmentId = NEW.id),
+        totalFee = totalFee - (SELECT total(totalFee) FROM Bills WHERE appointmentId = NEW.id)
+    WHERE date = OLD.date AND doctorId = OLD.doctorId;
+
+    INSERT INTO BillingDaily (date, doctorId, bills, medicationFee, consultationFee, surgeryFee, totalFee)
+    SELECT NEW.date, NEW.doctorId, count(*), total(medicationFee), total(consultationFee), total(surgeryFee), total(totalFee)
+    FROM Bills WHERE appointmentId = NEW.id
+    GROUP BY appointmentId
+    ON CONFLICT (date, doctorId) DO UPDATE SET
+        bills = bills + excluded.bills,
+        medicationFee = medicationFee + excluded.medicationFee,
+        consultationFee = consultationFee + excluded.consultationFee,
+        surgeryFee = surgeryFee + excluded.surgeryFee,
+        totalFee = totalFee + excluded.totalFee;
+END;
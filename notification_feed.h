@@ -0,0 +1,151 @@
+#pragma once
+#include <sqlite3.h>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "database.h"
+#include "json_stream.h"
+
+// ------------------ Notification Feed ------------------
+// The most recent notifications, kept in memory in id order. Cursor reads that start inside
+// the ring are answered without touching the database, and every committed notification is
+// pushed to the live subscribers (WebSocket connections) as it is published. Only the writer
+// inserts notifications, and it publishes them after COMMIT, so the ring never shows rows a
+// reader of the table could not see yet.
+
+struct Notification {
+    long long id;
+    std::string itemName;
+    std::string message;
+    std::string timestamp;
+};
+
+inline void writeNotification(JsonStreamWriter& writer, const Notification& notification) {
+    writer.beginObject();
+    writer.key("id");
+    writer.value(notification.id);
+    writer.key("itemName");
+    writer.value(notification.itemName);
+    writer.key("message");
+    writer.value(notification.message);
+    writer.key("timestamp");
+    writer.value(notification.timestamp);
+    writer.endObject();
+}
+
+inline std::string notificationJson(const Notification& notification) {
+    std::string json;
+    StringSink sink(json);
+    JsonStreamWriter writer(sink, 512);
+    writeNotification(writer, notification);
+    writer.finish();
+    return json;
+}
+
+class NotificationFeed {
+public:
+    // Receives each published notification as a JSON text frame
+    using Subscriber = std::function<void(const std::string& frame)>;
+
+    explicit NotificationFeed(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+    NotificationFeed(const NotificationFeed&) = delete;
+    NotificationFeed& operator=(const NotificationFeed&) = delete;
+
+    // Fills the ring with the newest stored notifications; call once at startup
+    void load(DbConnection& conn) {
+        CachedStatement stmt = conn.prepare(
+            "SELECT id, itemName, message, timestamp FROM Notifications ORDER BY id DESC LIMIT ?");
+        if (!stmt) {
+            throw std::runtime_error(std::string("Failed to read notifications: ") + sqlite3_errmsg(conn.handle()));
+        }
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(capacity_));
+        std::deque<Notification> newest;
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            newest.push_front({sqlite3_column_int64(stmt, 0), text(stmt, 1), text(stmt, 2), text(stmt, 3)});
+        }
+        if (rc != SQLITE_DONE) {
+            throw std::runtime_error(std::string("Failed to read notifications: ") + sqlite3_errmsg(conn.handle()));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        // A full ring may have older rows before it; a partial one holds the whole table
+        floorId_ = newest.size() == capacity_ ? newest.front().id - 1 : 0;
+        ring_ = std::move(newest);
+    }
+
+    // Appends committed notifications (in id order) and sends them to every subscriber
+    void publish(const std::vector<Notification>& batch) {
+        if (batch.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Notification& notification : batch) {
+            ring_.push_back(notification);
+            if (ring_.size() > capacity_) {
+                floorId_ = ring_.front().id;
+                ring_.pop_front();
+            }
+            if (subscribers_.empty()) {
+                continue;
+            }
+            std::string frame = notificationJson(notification);
+            // Under the lock, so unsubscribe() guarantees no further calls once it returns
+            for (auto& entry : subscribers_) {
+                entry.second(frame);
+            }
+        }
+    }
+
+    // Copies up to `limit` notifications with id > afterId into `out`, and sets `hasMore` if
+    // the ring holds further ones. False if older notifications than the ring keeps are
+    // needed; the caller then reads the table instead.
+    bool readAfter(long long afterId, size_t limit, std::vector<Notification>& out, bool& hasMore) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (afterId < floorId_) {
+            return false;
+        }
+        auto it = std::upper_bound(ring_.begin(), ring_.end(), afterId,
+                                   [](long long id, const Notification& n) { return id < n.id; });
+        for (; it != ring_.end() && out.size() < limit; ++it) {
+            out.push_back(*it);
+        }
+        hasMore = it != ring_.end();
+        return true;
+    }
+
+    // `key` identifies the subscriber for unsubscribe(), e.g. the connection's address
+    void subscribe(const void* key, Subscriber subscriber) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers_[key] = std::move(subscriber);
+    }
+
+    void unsubscribe(const void* key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers_.erase(key);
+    }
+
+    size_t subscriberCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return subscribers_.size();
+    }
+
+private:
+    static std::string text(sqlite3_stmt* stmt, int col) {
+        const unsigned char* value = sqlite3_column_text(stmt, col);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::deque<Notification> ring_;
+    long long floorId_ = 0;  // every notification with a larger id is in the ring
+    std::unordered_map<const void*, Subscriber> subscribers_;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+// Lookups on the request hot paths that must be answered from an index.
+// Any of them showing up as a full table scan in EXPLAIN QUERY PLAN is a regression.
+inline const std::vector<std::string>& hotPathQueries() {
+    static const std::vector<std::string> queries = {
+        "UPDATE Inventory SET quantity = quantity + ? WHERE itemName = ? RETURNING quantity",
+        // Low-stock evaluator (see inventory.h)
+        "SELECT id, itemName, quantity FROM Inventory WHERE lowStockNotified = 0 AND quantity < ?",
+        "UPDATE Inventory SET lowStockNotified = 0 WHERE lowStockNotified = 1 AND quantity >= ?",
+        // Claim processor (see claims.h)
+        "SELECT id, patientId, totalFee, insuranceCompany FROM Bills WHERE claimStatus = 'Pending' AND id > ? ORDER BY id LIMIT ?",
+        "UPDATE Bills SET claimStatus = ? WHERE id = ? AND claimStatus = 'Pending'",
+        "SELECT id FROM Appointments WHERE doctorId = ? AND date = ? AND time = ?",
+        "SELECT time FROM Appointments WHERE doctorId = ? AND date = ?",
+        "SELECT * FROM Bills WHERE patientId = ?",
+        "SELECT id FROM Bills WHERE claimStatus = ?",
+        "SELECT * FROM Prescriptions WHERE patientId = ?",
+        // Patient timeline (see timeline.h)
+        "SELECT id FROM Appointments WHERE patientId = ? ORDER BY date, time",
+        "SELECT prescriptionId FROM Prescriptions WHERE patientId = ? ORDER BY datePrescribed",
+        "SELECT recordId FROM MedicalRecords WHERE patientId = ? ORDER BY visitDate",
+        "SELECT * FROM Notifications WHERE timestamp > ?",
+        "SELECT id FROM Patients WHERE id = ?",
+        "SELECT id FROM Doctors WHERE id = ?",
+        // Filtered keyset pages (see list_query.h)
+        "SELECT id, time FROM Appointments WHERE id > ? AND doctorId = ? AND date = ? ORDER BY id LIMIT ?",
+        "SELECT id, totalFee FROM Bills WHERE id > ? AND claimStatus = ? ORDER BY id LIMIT ?",
+        "SELECT id, totalFee FROM Bills WHERE id > ? AND patientId = ? ORDER BY id LIMIT ?",
+    };
+    return queries;
+}
+
+// Returns one message per hot-path query whose plan contains a full table scan
+// (or that no longer prepares). An empty result means every lookup uses an index.
+inline std::vector<std::string> findTableScans(sqlite3* db) {
+    std::vector<std::string> problems;
+    for (const auto& query : hotPathQueries()) {
+        std::string explain = "EXPLAIN QUERY PLAN " + query;
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            problems.push_back(query + " -> failed to prepare: " + sqlite3_errmsg(db));
+            continue;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            // Columns: id, parent, notused, detail (e.g. "SCAN Bills" or "SEARCH Bills USING INDEX ...")
+            const char* detail = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+            if (detail && std::string(detail).rfind("SCAN ", 0) == 0) {
+                problems.push_back(query + " -> " + detail);
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    return problems;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <string>
+#include <nlohmann/json.hpp>
+
+//Data Structures
+struct Patient {
+    int id;
+    std::string name;
+    std::string address;
+    std::string medicalHistory;
+    bool hasInsurance;
+    std::string insuranceCompany;
+};
+
+struct Doctor {
+    int id;
+    std::string name;
+    std::string specialty;
+    std::string contactInfo;
+};
+
+struct Appointment {
+    int patientId;
+    int doctorId;
+    std::string date;  // YYYY-MM-DD
+    std::string time;  // HH:MM
+};
+
+struct MedicalRecord {
+    int recordId;
+    int patientId;
+    std::string visitDate;  // YYYY-MM-DD
+    std::string notes;
+    std::string diagnosis;
+};
+
+struct Prescription {
+    int prescriptionId;
+    int patientId;
+    int doctorId;
+    std::string medication;
+    std::string dosage;
+    std::string instructions;
+    std::string datePrescribed; // YYYY-MM-DD
+};
+
+struct Bill {
+    int billId;
+    int patientId;
+    int appointmentId;
+    double medicationFee;
+    double consultationFee;
+    double surgeryFee;
+    double totalFee;
+    bool isInsured;
+    bool claimed;
+    std::string insuranceCompany;
+    std::string claimStatus; // e.g. "Pending", "Approved", "Denied"
+};
+
+// ------------------ JSON Conversions ------------------
+// Field names match the original data files. from_json throws if a field is missing or has
+// the wrong type; loaders skip such rows.
+
+inline void to_json(nlohmann::json& j, const Patient& p) {
+    j = {{"id", p.id}, {"name", p.name}, {"address", p.address}, {"medicalHistory", p.medicalHistory},
+         {"hasInsurance", p.hasInsurance}, {"insuranceCompany", p.insuranceCompany}};
+}
+
+inline void from_json(const nlohmann::json& j, Patient& p) {
+    j.at("id").get_to(p.id);
+    j.at("name").get_to(p.name);
+    j.at("address").get_to(p.address);
+    j.at("medicalHistory").get_to(p.medicalHistory);
+    j.at("hasInsurance").get_to(p.hasInsurance);
+    j.at("insuranceCompany").get_to(p.insuranceCompany);
+}
+
+inline void to_json(nlohmann::json& j, const Doctor& d) {
+    j = {{"id", d.id}, {"name", d.name}, {"specialty", d.specialty}, {"contactInfo", d.contactInfo}};
+}
+
+inline void from_json(const nlohmann::json& j, Doctor& d) {
+    j.at("id").get_to(d.id);
+    j.at("name").get_to(d.name);
+    j.at("specialty").get_to(d.specialty);
+    j.at("contactInfo").get_to(d.contactInfo);
+}
+
+inline void to_json(nlohmann::json& j, const Appointment& a) {
+    j = {{"patientId", a.patientId}, {"doctorId", a.doctorId}, {"date", a.date}, {"time", a.time}};
+}
+
+inline void from_json(const nlohmann::json& j, Appointment& a) {
+    j.at("patientId").get_to(a.patientId);
+    j.at("doctorId").get_to(a.doctorId);
+    j.at("date").get_to(a.date);
+    j.at("time").get_to(a.time);
+}
+
+inline void to_json(nlohmann::json& j, const MedicalRecord& r) {
+    j = {{"recordId", r.recordId}, {"patientId", r.patientId}, {"visitDate", r.visitDate},
+         {"notes", r.notes}, {"diagnosis", r.diagnosis}};
+}
+
+inline void from_json(const nlohmann::json& j, MedicalRecord& r) {
+    j.at("recordId").get_to(r.recordId);
+    j.at("patientId").get_to(r.patientId);
+    j.at("visitDate").get_to(r.visitDate);
+    j.at("notes").get_to(r.notes);
+    j.at("diagnosis").get_to(r.diagnosis);
+}
+
+inline void to_json(nlohmann::json& j, const Prescription& p) {
+    j = {{"prescriptionId", p.prescriptionId}, {"patientId", p.patientId}, {"doctorId", p.doctorId},
+         {"medication", p.medication}, {"dosage", p.dosage}, {"instructions", p.instructions},
+         {"datePrescribed", p.datePrescribed}};
+}
+
+inline void from_json(const nlohmann::json& j, Prescription& p) {
+    j.at("prescriptionId").get_to(p.prescriptionId);
+    j.at("patientId").get_to(p.patientId);
+    j.at("doctorId").get_to(p.doctorId);
+    j.at("medication").get_to(p.medication);
+    j.at("dosage").get_to(p.dosage);
+    j.at("instructions").get_to(p.instructions);
+    j.at("datePrescribed").get_to(p.datePrescribed);
+}
+
+inline void to_json(nlohmann::json& j, const Bill& b) {
+    j = {{"billId", b.billId}, {"patientId", b.patientId}, {"appointmentId", b.appointmentId},
+         {"medicationFee", b.medicationFee}, {"consultationFee", b.consultationFee},
+         {"surgeryFee", b.surgeryFee}, {"totalFee", b.totalFee}, {"isInsured", b.isInsured},
+         {"claimed", b.claimed}, {"insuranceCompany", b.insuranceCompany}, {"claimStatus", b.claimStatus}};
+}
+
+inline void from_json(const nlohmann::json& j, Bill& b) {
+    j.at("billId").get_to(b.billId);
+    j.at("patientId").get_to(b.patientId);
+    j.at("appointmentId").get_to(b.appointmentId);
+    j.at("medicationFee").get_to(b.medicationFee);
+    j.at("consultationFee").get_to(b.consultationFee);
+    j.at("surgeryFee").get_to(b.surgeryFee);
+    j.at("totalFee").get_to(b.totalFee);
+    j.at("isInsured").get_to(b.isInsured);
+    j.at("claimed").get_to(b.claimed);
+    j.at("insuranceCompany").get_to(b.insuranceCompany);
+    j.at("claimStatus").get_to(b.claimStatus);
+}
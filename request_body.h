@@ -0,0 +1,160 @@
+#pragma once
+#include "crow.h"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ------------------ JSON Request Bodies ------------------
+// Field accessors return string_views into the parsed document, which stay valid as long as
+// the document (or the BatchBody holding it) is alive.
+
+// Reads a string field; false if it is missing or not a string
+inline bool getStringField(const crow::json::rvalue& row, const char* key, std::string_view& out) {
+    if (!row.has(key) || row[key].t() != crow::json::type::String) {
+        return false;
+    }
+    auto text = row[key].s();
+    out = std::string_view(text.begin(), text.size());
+    return true;
+}
+
+// Reads an integer field; false if it is missing or not a whole number
+inline bool getIntField(const crow::json::rvalue& row, const char* key, long long& out) {
+    if (!row.has(key) || row[key].t() != crow::json::type::Number) {
+        return false;
+    }
+    double number = row[key].d();
+    out = row[key].i();
+    return static_cast<double>(out) == number;
+}
+
+inline bool getNumberField(const crow::json::rvalue& row, const char* key, double& out) {
+    if (!row.has(key) || row[key].t() != crow::json::type::Number) {
+        return false;
+    }
+    out = row[key].d();
+    return true;
+}
+
+// Optional forms for partial updates: an absent key leaves `out` empty; false only if the key
+// is present with the wrong type
+inline bool getOptionalStringField(const crow::json::rvalue& row, const char* key, std::optional<std::string_view>& out) {
+    if (!row.has(key)) {
+        return true;
+    }
+    std::string_view text;
+    if (!getStringField(row, key, text)) {
+        return false;
+    }
+    out = text;
+    return true;
+}
+
+inline bool getOptionalIntField(const crow::json::rvalue& row, const char* key, std::optional<long long>& out) {
+    if (!row.has(key)) {
+        return true;
+    }
+    long long number;
+    if (!getIntField(row, key, number)) {
+        return false;
+    }
+    out = number;
+    return true;
+}
+
+inline bool getOptionalNumberField(const crow::json::rvalue& row, const char* key, std::optional<double>& out) {
+    if (!row.has(key)) {
+        return true;
+    }
+    double number;
+    if (!getNumberField(row, key, number)) {
+        return false;
+    }
+    out = number;
+    return true;
+}
+
+// Body of a single-record request: one JSON object, parsed in place. Empty `error` on success.
+inline crow::json::rvalue loadObjectBody(const crow::request& req, std::string& error) {
+    crow::json::rvalue doc = crow::json::load(req.body.data(), req.body.size());
+    if (!doc || doc.t() != crow::json::type::Object) {
+        error = "Request body must be a JSON object";
+    }
+    return doc;
+}
+
+constexpr size_t kMaxBatchRows = 10000;
+
+// Rows of a batch request: either a JSON array of objects or NDJSON (one object per line,
+// selected by an application/x-ndjson Content-Type or a body that does not start with '[').
+class BatchBody {
+public:
+    bool parse(const crow::request& req, std::string& error) {
+        const std::string& body = req.body;
+        size_t first = body.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos) {
+            error = "Empty request body";
+            return false;
+        }
+
+        bool ndjson = req.get_header_value("Content-Type").find("ndjson") != std::string::npos || body[first] != '[';
+        if (!ndjson) {
+            documents_.push_back(crow::json::load(body));
+            const crow::json::rvalue& doc = documents_.back();
+            if (!doc || doc.t() != crow::json::type::List) {
+                error = "Request body must be a JSON array of objects";
+                return false;
+            }
+            for (const auto& row : doc) {
+                rows_.push_back(&row);
+            }
+        } else {
+            size_t start = 0;
+            size_t lineNumber = 0;
+            while (start < body.size()) {
+                size_t end = body.find('\n', start);
+                if (end == std::string::npos) {
+                    end = body.size();
+                }
+                ++lineNumber;
+                std::string_view line(body.data() + start, end - start);
+                start = end + 1;
+                if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+                    continue;
+                }
+                documents_.push_back(crow::json::load(line.data(), line.size()));
+                if (!documents_.back()) {
+                    error = "Invalid JSON on line " + std::to_string(lineNumber);
+                    return false;
+                }
+            }
+            for (const auto& doc : documents_) {
+                rows_.push_back(&doc);
+            }
+        }
+
+        if (rows_.empty()) {
+            error = "Batch contains no rows";
+            return false;
+        }
+        if (rows_.size() > kMaxBatchRows) {
+            error = "Batch too large: at most " + std::to_string(kMaxBatchRows) + " rows";
+            return false;
+        }
+        for (size_t i = 0; i < rows_.size(); ++i) {
+            if (rows_[i]->t() != crow::json::type::Object) {
+                error = "Row " + std::to_string(i) + " is not a JSON object";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t size() const { return rows_.size(); }
+    const crow::json::rvalue& operator[](size_t i) const { return *rows_[i]; }
+
+private:
+    std::vector<crow::json::rvalue> documents_;
+    std::vector<const crow::json::rvalue*> rows_;
+};
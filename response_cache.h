@@ -0,0 +1,176 @@
+#pragma once
+#include "crow.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "compression.h"
+#include "entity_cache.h"
+#include "table_versions.h"
+
+// ------------------ Response Cache ------------------
+// For GET routes whose body depends only on the URL and one table. Responses are cached
+// under (table version, URL), so a write to the table makes every older entry unreachable
+// and it ages out of the LRU. Each response carries an ETag built from the version; a client
+// that sends it back in If-None-Match gets 304 Not Modified without a lookup or a query.
+// Routes that negotiate a body format pass it as the variant, which is part of both the key
+// and the ETag, so a JSON and a CBOR rendering of the same URL are cached side by side.
+// A body is compressed at most once per content coding, on the first request that accepts
+// it, and the compressed copy is kept with the entry.
+
+struct CachedResponse {
+    CachedResponse(std::string body, std::string contentType)
+        : body(std::move(body)), contentType(std::move(contentType)) {}
+
+    // The body in `encoding`, compressed on first use
+    const std::string& encoded(ContentEncoding encoding) const {
+        size_t index = static_cast<size_t>(encoding);
+        std::call_once(encodedOnce_[index], [&] {
+            encoded_[index] = compressBody(body, encoding, compressionLevel(encoding, true));
+        });
+        return encoded_[index];
+    }
+
+    const std::string body;
+    const std::string contentType;
+
+private:
+    mutable std::array<std::once_flag, kContentEncodingCount> encodedOnce_;
+    mutable std::array<std::string, kContentEncodingCount> encoded_;
+};
+
+// True if an If-None-Match header value lists `etag` (or is "*"); weak tags compare equal
+inline bool etagMatches(std::string_view header, std::string_view etag) {
+    while (!header.empty()) {
+        size_t comma = header.find(',');
+        std::string_view tag = header.substr(0, comma);
+        header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+        while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) {
+            tag.remove_prefix(1);
+        }
+        while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) {
+            tag.remove_suffix(1);
+        }
+        if (tag.substr(0, 2) == "W/") {
+            tag.remove_prefix(2);
+        }
+        if (tag == "*" || tag == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+class ResponseCache {
+public:
+    // Bodies larger than `maxBodyBytes` are served but not kept
+    ResponseCache(const TableVersions& versions, size_t capacity, size_t maxBodyBytes)
+        : versions_(versions), maxBodyBytes_(maxBodyBytes), entries_(capacity) {}
+
+    // Answers `req` from the cache when `table` has not changed, otherwise calls render()
+    template <typename Render>
+    crow::response serve(const crow::request& req, const std::string& table, Render render,
+                         std::string_view variant = {}) {
+        uint64_t version = versions_.get(table);
+        ContentEncoding encoding = negotiateEncoding(req);
+        std::string etag = "\"" + table + "-" + std::to_string(versions_.epoch()) + "-" + std::to_string(version);
+        if (!variant.empty()) {
+            etag += '-';
+            etag.append(variant);
+        }
+        // A compressed body is a different representation and needs its own tag. Bodies too
+        // small to compress go out as they are, under the plain tag, whatever the client accepts.
+        std::string encodedEtag = etag;
+        if (encoding != ContentEncoding::Identity) {
+            encodedEtag += '-';
+            encodedEtag += encodingName(encoding);
+            encodedEtag += '"';
+        }
+        etag += '"';
+
+        // The client's copy is current if it holds what this request would be sent: known up
+        // front for a compressed copy, only once the body's size is known for a plain one
+        std::string ifNoneMatch = req.get_header_value("If-None-Match");
+        auto notModified = [&](bool compressed) -> std::optional<crow::response> {
+            const std::string& tag = compressed ? encodedEtag : etag;
+            if (!etagMatches(ifNoneMatch, tag)) {
+                return std::nullopt;
+            }
+            crow::response res(304);
+            setValidators(res, tag, variant);
+            return res;
+        };
+        if (auto res = notModified(encoding != ContentEncoding::Identity)) {
+            return std::move(*res);
+        }
+
+        std::string key = std::to_string(version) + ' ';
+        key.append(variant);
+        key += ' ';
+        key += req.raw_url;
+        if (auto hit = entries_.find(key)) {
+            bool compressed = compresses(encoding, (*hit)->body.size());
+            if (!compressed) {
+                if (auto res = notModified(false)) {
+                    return std::move(*res);
+                }
+            }
+            crow::response res(200);
+            setBody(res, **hit, encoding);
+            res.set_header("Content-Type", (*hit)->contentType);
+            setValidators(res, compressed ? encodedEtag : etag, variant);
+            return res;
+        }
+
+        crow::response res = render();
+        if (res.code != 200) {
+            return res;
+        }
+        // Bodies too large to keep are compressed by ResponseCompression under the same rule
+        bool compressed = compresses(encoding, res.body.size());
+        if (!compressed) {
+            if (auto notModifiedRes = notModified(false)) {
+                return std::move(*notModifiedRes);
+            }
+        }
+        // The data may already be newer than `version`; then the next request simply misses.
+        if (res.body.size() <= maxBodyBytes_) {
+            auto entry = std::make_shared<const CachedResponse>(res.body, res.get_header_value("Content-Type"));
+            entries_.put(key, entry);
+            setBody(res, *entry, encoding);
+        }
+        setValidators(res, compressed ? encodedEtag : etag, variant);
+        return res;
+    }
+
+    long long hits() const { return entries_.hits(); }
+    long long misses() const { return entries_.misses(); }
+
+private:
+    static bool compresses(ContentEncoding encoding, size_t bodyBytes) {
+        return encoding != ContentEncoding::Identity && bodyBytes >= kMinCompressBytes;
+    }
+
+    static void setBody(crow::response& res, const CachedResponse& entry, ContentEncoding encoding) {
+        if (!compresses(encoding, entry.body.size())) {
+            res.body = entry.body;
+            return;
+        }
+        res.body = entry.encoded(encoding);
+        res.set_header("Content-Encoding", encodingName(encoding));
+    }
+
+    static void setValidators(crow::response& res, const std::string& etag, std::string_view variant) {
+        res.set_header("ETag", etag);
+        // Clients may keep the body but must revalidate before reusing it
+        res.set_header("Cache-Control", "no-cache");
+        res.set_header("Vary", variant.empty() ? "Accept-Encoding" : "Accept, Accept-Encoding");
+    }
+
+    const TableVersions& versions_;
+    size_t maxBodyBytes_;
+    ShardedLruCache<std::string, std::shared_ptr<const CachedResponse>> entries_;
+};
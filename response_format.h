@@ -0,0 +1,138 @@
+#pragma once
+#include "crow.h"
+#include <cstdlib>
+#include <optional>
+#include <string_view>
+#include "binary_stream.h"
+#include "compression.h"
+#include "json_stream.h"
+
+// ------------------ Response Formats ------------------
+// List and record endpoints can answer in CBOR or MessagePack instead of JSON when the client
+// asks for it in Accept. The body is produced by the same serializer for every format: it is
+// written once against a generic writer and instantiated for each of the three.
+
+enum class BodyFormat { Json, Cbor, MsgPack };
+
+inline const char* formatContentType(BodyFormat format) {
+    switch (format) {
+        case BodyFormat::Cbor: return "application/cbor";
+        case BodyFormat::MsgPack: return "application/msgpack";
+        default: return "application/json";
+    }
+}
+
+// Short name used to tell cached variants apart
+inline const char* formatName(BodyFormat format) {
+    switch (format) {
+        case BodyFormat::Cbor: return "cbor";
+        case BodyFormat::MsgPack: return "msgpack";
+        default: return "json";
+    }
+}
+
+// Picks the format with the highest q-value in an Accept header. A format named outright beats
+// one only covered by a wildcard at the same q, and remaining ties go to JSON, so browsers and
+// clients that send no Accept at all keep getting JSON. Nothing acceptable also means JSON.
+inline BodyFormat negotiateFormat(std::string_view accept) {
+    struct Candidate {
+        BodyFormat format;
+        double q = 0;
+        int specificity = -1;  // 2 exact type, 1 application/*, 0 */*, -1 not mentioned
+    };
+    Candidate candidates[] = {{BodyFormat::Json}, {BodyFormat::Cbor}, {BodyFormat::MsgPack}};
+
+    auto trim = [](std::string_view text) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+        return text;
+    };
+
+    while (!accept.empty()) {
+        size_t comma = accept.find(',');
+        std::string_view range = accept.substr(0, comma);
+        accept = comma == std::string_view::npos ? std::string_view() : accept.substr(comma + 1);
+
+        size_t semicolon = range.find(';');
+        std::string_view type = trim(range.substr(0, semicolon));
+        double q = 1;
+        while (semicolon != std::string_view::npos) {
+            range = range.substr(semicolon + 1);
+            semicolon = range.find(';');
+            std::string_view param = trim(range.substr(0, semicolon));
+            if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                q = std::strtod(std::string(param.substr(2)).c_str(), nullptr);
+            }
+        }
+
+        for (Candidate& candidate : candidates) {
+            int specificity = -1;
+            if (type == "*/*") {
+                specificity = 0;
+            } else if (type == "application/*") {
+                specificity = 1;
+            } else if (type == formatContentType(candidate.format) ||
+                       (candidate.format == BodyFormat::MsgPack &&
+                        (type == "application/x-msgpack" || type == "application/vnd.msgpack"))) {
+                specificity = 2;
+            }
+            // The most specific range that matches decides the q-value
+            if (specificity > candidate.specificity) {
+                candidate.specificity = specificity;
+                candidate.q = q;
+            }
+        }
+    }
+
+    const Candidate* best = &candidates[0];
+    for (const Candidate& candidate : candidates) {
+        if (candidate.q > best->q || (candidate.q == best->q && candidate.specificity > best->specificity)) {
+            best = &candidate;
+        }
+    }
+    return best->q > 0 ? best->format : BodyFormat::Json;
+}
+
+inline BodyFormat negotiateFormat(const crow::request& req) {
+    return negotiateFormat(req.get_header_value("Accept"));
+}
+
+// Builds a 200 response in `format` by calling emit(writer) with the matching stream writer.
+// emit returns an error response to send instead, or nullopt once the body is complete. With
+// an `encoding` the body is compressed while it is written, whatever its size.
+template <typename Emit>
+crow::response formatResponse(BodyFormat format, Emit emit, ContentEncoding encoding = ContentEncoding::Identity) {
+    crow::response res(200);
+    res.set_header("Content-Type", formatContentType(format));
+    res.set_header("Vary", "Accept");
+    StringSink body(res.body);
+    std::optional<CompressingSink> compressor;
+    if (encoding != ContentEncoding::Identity) {
+        compressor.emplace(body, encoding, compressionLevel(encoding, false));
+        setContentEncoding(res, encoding);
+    }
+    ByteSink& sink = compressor ? static_cast<ByteSink&>(*compressor) : body;
+    auto run = [&](auto& writer) -> std::optional<crow::response> {
+        std::optional<crow::response> error = emit(writer);
+        if (!error) {
+            writer.finish();
+        }
+        return error;
+    };
+
+    std::optional<crow::response> error;
+    if (format == BodyFormat::Cbor) {
+        CborStreamWriter writer(sink);
+        error = run(writer);
+    } else if (format == BodyFormat::MsgPack) {
+        MsgPackStreamWriter writer(sink);
+        error = run(writer);
+    } else {
+        JsonStreamWriter writer(sink);
+        error = run(writer);
+    }
+    if (error) {
+        return std::move(*error);
+    }
+    return res;
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <sqlite3.h>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include "database.h"
+#include "validation.h"
+
+// ------------------ Doctor Schedule Index ------------------
+// Appointments are booked in 10-minute slots from 09:00 to 17:00 (see isValidAppointmentTime),
+// i.e. 49 slots per day, so one doctor's day fits in a single 64-bit mask. The index is built
+// from the Appointments table at startup and updated by every booking, so availability checks
+// never touch SQLite.
+
+constexpr int kFirstSlotMinute = 9 * 60;
+constexpr int kSlotMinutes = 10;
+constexpr int kSlotsPerDay = (17 * 60 - kFirstSlotMinute) / kSlotMinutes + 1;  // 49
+
+// Slot number for an "HH:MM" appointment time, or -1 outside the bookable grid
+inline int slotForTime(std::string_view time) {
+    int minutes = 0;
+    if (!parseClockTime(time, minutes)) {
+        return -1;
+    }
+    int offset = minutes - kFirstSlotMinute;
+    if (offset < 0 || offset % kSlotMinutes != 0 || offset / kSlotMinutes >= kSlotsPerDay) {
+        return -1;
+    }
+    return offset / kSlotMinutes;
+}
+
+inline std::string timeForSlot(int slot) {
+    int minutes = kFirstSlotMinute + slot * kSlotMinutes;
+    std::string time = "00:00";
+    time[0] = static_cast<char>('0' + minutes / 600);
+    time[1] = static_cast<char>('0' + minutes / 60 % 10);
+    time[3] = static_cast<char>('0' + minutes % 60 / 10);
+    time[4] = static_cast<char>('0' + minutes % 10);
+    return time;
+}
+
+// "YYYY-MM-DD" packed as YYYYMMDD, or -1 if it is not a calendar date
+inline int dayKeyForDate(std::string_view date) {
+    int year = 0, month = 0, day = 0;
+    if (!parseDate(date, year, month, day)) {
+        return -1;
+    }
+    return year * 10000 + month * 100 + day;
+}
+
+class ScheduleIndex {
+public:
+    // Marks the slot as booked; false if it already was (or the date/time is off the grid)
+    bool tryReserve(int doctorId, std::string_view date, std::string_view time) {
+        int slot = slotForTime(time);
+        int day = dayKeyForDate(date);
+        if (slot < 0 || day < 0) {
+            return false;
+        }
+        uint64_t bit = uint64_t{1} << slot;
+        Shard& shard = shardFor(doctorId, day);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        uint64_t& mask = shard.days[key(doctorId, day)];
+        if (mask & bit) {
+            return false;
+        }
+        mask |= bit;
+        return true;
+    }
+
+    // Undoes a reservation whose database insert did not commit
+    void release(int doctorId, std::string_view date, std::string_view time) {
+        int slot = slotForTime(time);
+        int day = dayKeyForDate(date);
+        if (slot < 0 || day < 0) {
+            return;
+        }
+        Shard& shard = shardFor(doctorId, day);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.days.find(key(doctorId, day));
+        if (it != shard.days.end()) {
+            it->second &= ~(uint64_t{1} << slot);
+            if (it->second == 0) {
+                shard.days.erase(it);
+            }
+        }
+    }
+
+    bool isTaken(int doctorId, std::string_view date, std::string_view time) const {
+        int slot = slotForTime(time);
+        return slot >= 0 && (bookedMask(doctorId, date) >> slot & 1) != 0;
+    }
+
+    // Bit i set means slot i (09:00 + 10*i minutes) is booked
+    uint64_t bookedMask(int doctorId, std::string_view date) const {
+        int day = dayKeyForDate(date);
+        if (day < 0) {
+            return 0;
+        }
+        const Shard& shard = shardFor(doctorId, day);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.days.find(key(doctorId, day));
+        return it == shard.days.end() ? 0 : it->second;
+    }
+
+    // Rebuilds the index from the Appointments table; returns the number of booked slots
+    size_t load(DbConnection& conn) {
+        for (Shard& shard : shards_) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.days.clear();
+        }
+        CachedStatement stmt = conn.prepare("SELECT doctorId, date, time FROM Appointments");
+        if (!stmt) {
+            throw std::runtime_error("Cannot load schedule index: " + std::string(sqlite3_errmsg(conn.handle())));
+        }
+        size_t count = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* date = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            const char* time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+            if (date && time && tryReserve(sqlite3_column_int(stmt, 0), date, time)) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+private:
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<uint64_t, uint64_t> days;
+    };
+
+    static constexpr size_t kShards = 64;
+
+    static uint64_t key(int doctorId, int day) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(doctorId)) << 32 | static_cast<uint32_t>(day);
+    }
+
+    Shard& shardFor(int doctorId, int day) { return shards_[(key(doctorId, day) * 0x9E3779B97F4A7C15ull) >> 58]; }
+    const Shard& shardFor(int doctorId, int day) const {
+        return shards_[(key(doctorId, day) * 0x9E3779B97F4A7C15ull) >> 58];
+    }
+
+    std::array<Shard, kShards> shards_;
+};
+
+// Scoped reservation of one slot: released on scope exit unless keep() was called once the
+// booking committed (or the database turned out to already hold the slot).
+class SlotReservation {
+public:
+    SlotReservation(ScheduleIndex& index, int doctorId, std::string date, std::string time)
+        : index_(index), doctorId_(doctorId), date_(std::move(date)), time_(std::move(time)),
+          reserved_(index_.tryReserve(doctorId_, date_, time_)) {}
+
+    SlotReservation(const SlotReservation&) = delete;
+    SlotReservation& operator=(const SlotReservation&) = delete;
+
+    ~SlotReservation() {
+        if (reserved_ && !kept_) {
+            index_.release(doctorId_, date_, time_);
+        }
+    }
+
+    // False if the slot was already booked
+    bool reserved() const { return reserved_; }
+    void keep() { kept_ = true; }
+
+private:
+    ScheduleIndex& index_;
+    int doctorId_;
+    std::string date_;
+    std::string time_;
+    bool reserved_;
+    bool kept_ = false;
+};
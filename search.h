@@ -0,0 +1,176 @@
+#pragma once
+#include "crow.h"
+#include <sqlite3.h>
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "database.h"
+#include "json_stream.h"
+#include "list_query.h"
+#include "validation.h"
+
+// ------------------ Full-Text Search ------------------
+// /search runs against the FTS5 indexes from migrations/0004_search.sql, which triggers keep in
+// step with Patients and Prescriptions. Hits are ordered by bm25 with the name/medication
+// column weighted above free text, and joined back to their table by rowid.
+
+constexpr long long kDefaultSearchLimit = 20;
+constexpr long long kMaxSearchLimit = 100;
+constexpr size_t kMaxSearchTerms = 16;
+
+// Turns free text into an FTS5 query: every word becomes a quoted term (so FTS5 operators and
+// column filters in user input are inert), all terms must match, and the last one also matches
+// as a prefix so partially typed words find results. Empty if the text has no words.
+inline std::string buildMatchQuery(std::string_view text) {
+    // Letters, digits and any non-ASCII byte (UTF-8) form words, as for the unicode61 tokenizer
+    auto isWordByte = [](unsigned char c) { return c >= 0x80 || std::isalnum(c); };
+    std::string query;
+    size_t terms = 0;
+    size_t i = 0;
+    while (i < text.size() && terms < kMaxSearchTerms) {
+        while (i < text.size() && !isWordByte(static_cast<unsigned char>(text[i]))) {
+            ++i;
+        }
+        size_t start = i;
+        while (i < text.size() && isWordByte(static_cast<unsigned char>(text[i]))) {
+            ++i;
+        }
+        if (i == start) {
+            break;
+        }
+        if (!query.empty()) {
+            query += ' ';
+        }
+        query += '"';
+        query.append(text.substr(start, i - start));
+        query += '"';
+        ++terms;
+    }
+    if (!query.empty()) {
+        query += '*';
+    }
+    return query;
+}
+
+struct SearchSpec {
+    const char* type;   // ?type= value and response key
+    const char* index;  // FTS5 table
+    const char* query;  // SELECT ... WHERE <index> MATCH ?1, without ORDER BY / LIMIT
+    std::vector<ListColumn> columns;
+};
+
+inline const std::vector<SearchSpec>& searchSpecs() {
+    static const std::vector<SearchSpec> specs = {
+        {"patients", "PatientSearch",
+         "SELECT p.id, p.name, p.insuranceCompany, snippet(PatientSearch, -1, '[', ']', '...', 12), "
+         "PatientSearch.rank "
+         "FROM PatientSearch JOIN Patients p ON p.id = PatientSearch.rowid WHERE PatientSearch MATCH ?1",
+         {{"id", ColumnType::Integer}, {"name", ColumnType::Text}, {"insuranceCompany", ColumnType::Text},
+          {"snippet", ColumnType::Text}, {"score", ColumnType::Real}}},
+        {"prescriptions", "PrescriptionSearch",
+         "SELECT r.prescriptionId, r.patientId, r.doctorId, r.medication, r.dosage, r.datePrescribed, "
+         "snippet(PrescriptionSearch, -1, '[', ']', '...', 12), PrescriptionSearch.rank "
+         "FROM PrescriptionSearch JOIN Prescriptions r ON r.prescriptionId = PrescriptionSearch.rowid "
+         "WHERE PrescriptionSearch MATCH ?1",
+         {{"prescriptionId", ColumnType::Integer}, {"patientId", ColumnType::Integer},
+          {"doctorId", ColumnType::Integer}, {"medication", ColumnType::Text}, {"dosage", ColumnType::Text},
+          {"datePrescribed", ColumnType::Text}, {"snippet", ColumnType::Text}, {"score", ColumnType::Real}}},
+    };
+    return specs;
+}
+
+// Sorting by relevance scores every match (about 2us each), so a term that matches a large part
+// of the table ("patient", "daily") would take tens of milliseconds. Past this many matches the
+// newest ones are returned instead, which FTS5 streams in rowid order and stops at the limit.
+constexpr long long kMaxRankedMatches = 2000;
+
+// True if `match` has more than kMaxRankedMatches hits in `spec`; counting stops there
+inline bool tooManyToRank(DbConnection& conn, const SearchSpec& spec, const std::string& match, bool& failed) {
+    CachedStatement stmt = conn.prepare(std::string("SELECT count(*) FROM (SELECT 1 FROM ") + spec.index +
+                                        " WHERE " + spec.index + " MATCH ?1 LIMIT ?2)");
+    failed = !stmt;
+    if (failed) {
+        return false;
+    }
+    bindText(stmt, 1, match);
+    sqlite3_bind_int64(stmt, 2, kMaxRankedMatches + 1);
+    failed = sqlite3_step(stmt) != SQLITE_ROW;
+    return !failed && sqlite3_column_int64(stmt, 0) > kMaxRankedMatches;
+}
+
+// /search?q=<text>[&type=patients|prescriptions][&limit=N]
+// {"query": "...", "patients": [...], "prescriptions": [...], "order": {"patients": "relevance", ...}}
+// with each list best match first, or newest first if it had too many matches to rank
+inline crow::response searchRecords(DbConnection& conn, const crow::query_string& qs) {
+    const char* text = qs.get("q");
+    if (!text) {
+        return crow::response(400, "Missing required parameter: q");
+    }
+    std::string match = buildMatchQuery(text);
+    if (match.empty()) {
+        return crow::response(400, "Search text must contain at least one word");
+    }
+
+    const char* type = qs.get("type");
+    std::vector<const SearchSpec*> selected;
+    for (const SearchSpec& spec : searchSpecs()) {
+        if (!type || std::string_view(type) == spec.type) {
+            selected.push_back(&spec);
+        }
+    }
+    if (selected.empty()) {
+        return crow::response(400, "Invalid type: expected patients or prescriptions");
+    }
+
+    long long limit = kDefaultSearchLimit;
+    if (const char* limitStr = qs.get("limit")) {
+        if (!parseInt64Param(limitStr, limit) || limit < 1 || limit > kMaxSearchLimit) {
+            return crow::response(400, "Invalid limit: expected an integer from 1 to " + std::to_string(kMaxSearchLimit));
+        }
+    }
+
+    crow::response res(200);
+    res.set_header("Content-Type", "application/json");
+    StringSink sink(res.body);
+    JsonStreamWriter writer(sink);
+    writer.beginObject();
+    writer.key("query");
+    writer.value(match);
+    std::vector<bool> ranked;
+    for (const SearchSpec* spec : selected) {
+        bool failed = false;
+        ranked.push_back(!tooManyToRank(conn, *spec, match, failed));
+        if (failed) {
+            return crow::response(500, "Search failed");
+        }
+        CachedStatement stmt = conn.prepare(std::string(spec->query) + " ORDER BY " + spec->index +
+                                            (ranked.back() ? ".rank" : ".rowid DESC") + " LIMIT ?2");
+        if (!stmt) {
+            return crow::response(500, "Failed to prepare statement");
+        }
+        bindText(stmt, 1, match);
+        sqlite3_bind_int64(stmt, 2, limit);
+
+        writer.key(spec->type);
+        writer.beginArray();
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            writeRowObject(writer, stmt, spec->columns);
+        }
+        if (rc != SQLITE_DONE) {
+            return crow::response(500, "Search failed");
+        }
+        writer.endArray();
+    }
+    writer.key("order");
+    writer.beginObject();
+    for (size_t i = 0; i < selected.size(); ++i) {
+        writer.key(selected[i]->type);
+        writer.value(ranked[i] ? "relevance" : "newest");
+    }
+    writer.endObject();
+    writer.endObject();
+    writer.finish();
+    return res;
+}
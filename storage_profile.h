@@ -0,0 +1,148 @@
+#pragma once
+#include <sqlite3.h>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Storage tuning for every SQLite connection the server opens, loaded once at startup.
+// Defaults favour write latency: WAL with synchronous=NORMAL only fsyncs on checkpoint,
+// and readers of /patients or /bills never block the writer.
+struct StorageProfile {
+    std::string journalMode = "WAL";      // DELETE, TRUNCATE, PERSIST, MEMORY, WAL, OFF
+    std::string synchronous = "NORMAL";   // OFF, NORMAL, FULL, EXTRA
+    long long cacheSizeKiB = 65536;       // page cache per connection
+    long long mmapSizeBytes = 268435456;  // 0 disables memory-mapped I/O
+    std::string tempStore = "MEMORY";     // DEFAULT, FILE, MEMORY
+    int busyTimeoutMs = 5000;
+    // SQLite's inline auto-checkpoint; 0 leaves checkpointing to the background worker
+    int walAutoCheckpointPages = 0;
+    // Background checkpoint policy (WAL only): a PASSIVE checkpoint every interval,
+    // escalated to TRUNCATE once the WAL file grows past the threshold. 0 disables the worker.
+    int checkpointIntervalMs = 1000;
+    long long checkpointTruncateBytes = 67108864;
+    // Group commit (see write_queue.h): how long the writer waits for more requests before
+    // committing, and the most writes that share one transaction
+    int groupCommitWindowUs = 200;
+    int groupCommitMaxJobs = 256;
+    // Background claim adjudication (see claims.h). Off by default, so claims stay Pending
+    // until /approve_insurance decides them; when on, every pending claim is sent to the insurer
+    bool claimProcessorEnabled = false;
+    int claimProcessorWorkers = 4;
+    int claimProcessorBatchSize = 500;
+
+    bool isWal() const { return journalMode == "WAL"; }
+    bool backgroundCheckpoints() const { return isWal() && checkpointIntervalMs > 0; }
+};
+
+namespace storage_detail {
+
+inline std::string upper(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return value;
+}
+
+inline std::string oneOf(const std::string& field, const std::string& value,
+                         const std::vector<std::string>& allowed) {
+    std::string normalized = upper(value);
+    if (std::find(allowed.begin(), allowed.end(), normalized) == allowed.end()) {
+        throw std::runtime_error("Invalid storage setting " + field + ": " + value);
+    }
+    return normalized;
+}
+
+} // namespace storage_detail
+
+// Reads the profile from a JSON file; a missing file keeps the defaults.
+inline StorageProfile loadStorageProfile(const std::string& path) {
+    StorageProfile profile;
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cout << "No storage profile at " << path << ", using defaults." << std::endl;
+        return profile;
+    }
+
+    nlohmann::json cfg;
+    try {
+        file >> cfg;
+    } catch (const nlohmann::json::exception& e) {
+        throw std::runtime_error("Cannot parse storage profile " + path + ": " + e.what());
+    }
+
+    using storage_detail::oneOf;
+    profile.journalMode = oneOf("journalMode", cfg.value("journalMode", profile.journalMode),
+                                {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"});
+    profile.synchronous = oneOf("synchronous", cfg.value("synchronous", profile.synchronous),
+                                {"OFF", "NORMAL", "FULL", "EXTRA"});
+    profile.tempStore = oneOf("tempStore", cfg.value("tempStore", profile.tempStore),
+                              {"DEFAULT", "FILE", "MEMORY"});
+    profile.cacheSizeKiB = cfg.value("cacheSizeKiB", profile.cacheSizeKiB);
+    profile.mmapSizeBytes = cfg.value("mmapSizeBytes", profile.mmapSizeBytes);
+    profile.busyTimeoutMs = cfg.value("busyTimeoutMs", profile.busyTimeoutMs);
+    profile.walAutoCheckpointPages = cfg.value("walAutoCheckpointPages", profile.walAutoCheckpointPages);
+    if (cfg.contains("checkpoint")) {
+        const auto& checkpoint = cfg["checkpoint"];
+        profile.checkpointIntervalMs = checkpoint.value("intervalMs", profile.checkpointIntervalMs);
+        profile.checkpointTruncateBytes = checkpoint.value("truncateAboveBytes", profile.checkpointTruncateBytes);
+    }
+    if (cfg.contains("groupCommit")) {
+        const auto& groupCommit = cfg["groupCommit"];
+        profile.groupCommitWindowUs = groupCommit.value("windowUs", profile.groupCommitWindowUs);
+        profile.groupCommitMaxJobs = groupCommit.value("maxJobs", profile.groupCommitMaxJobs);
+    }
+    if (cfg.contains("claimProcessor")) {
+        const auto& claimProcessor = cfg["claimProcessor"];
+        profile.claimProcessorEnabled = claimProcessor.value("enabled", profile.claimProcessorEnabled);
+        profile.claimProcessorWorkers = claimProcessor.value("workers", profile.claimProcessorWorkers);
+        profile.claimProcessorBatchSize = claimProcessor.value("batchSize", profile.claimProcessorBatchSize);
+    }
+
+    if (profile.cacheSizeKiB < 0 || profile.mmapSizeBytes < 0 || profile.busyTimeoutMs < 0 ||
+        profile.walAutoCheckpointPages < 0 || profile.checkpointIntervalMs < 0 ||
+        profile.groupCommitWindowUs < 0) {
+        throw std::runtime_error("Invalid storage profile " + path + ": sizes and intervals must be non-negative");
+    }
+    if (profile.groupCommitMaxJobs < 1) {
+        throw std::runtime_error("Invalid storage profile " + path + ": groupCommit.maxJobs must be at least 1");
+    }
+    if (profile.claimProcessorWorkers < 1 || profile.claimProcessorBatchSize < 1) {
+        throw std::runtime_error("Invalid storage profile " + path +
+                                 ": claimProcessor.workers and batchSize must be at least 1");
+    }
+    // Without the background worker the WAL must still be checkpointed somewhere
+    if (profile.isWal() && !profile.backgroundCheckpoints() && profile.walAutoCheckpointPages == 0) {
+        profile.walAutoCheckpointPages = 1000;
+    }
+
+    std::cout << "Storage profile: journal_mode=" << profile.journalMode
+              << " synchronous=" << profile.synchronous
+              << " cache=" << profile.cacheSizeKiB << "KiB"
+              << " mmap=" << profile.mmapSizeBytes << "B" << std::endl;
+    return profile;
+}
+
+// Per-connection pragmas; journal_mode is persistent and applied once in initDatabase()
+inline void applyConnectionPragmas(sqlite3* db, const StorageProfile& profile) {
+    sqlite3_busy_timeout(db, profile.busyTimeoutMs);
+
+    std::string pragmas =
+        "PRAGMA synchronous=" + profile.synchronous + ";"
+        "PRAGMA cache_size=-" + std::to_string(profile.cacheSizeKiB) + ";"
+        "PRAGMA mmap_size=" + std::to_string(profile.mmapSizeBytes) + ";"
+        "PRAGMA temp_store=" + profile.tempStore + ";";
+    if (profile.isWal()) {
+        pragmas += "PRAGMA wal_autocheckpoint=" + std::to_string(profile.walAutoCheckpointPages) + ";";
+    }
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, pragmas.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::string error = errMsg ? errMsg : "unknown error";
+        sqlite3_free(errMsg);
+        throw std::runtime_error("Failed to apply storage pragmas: " + error);
+    }
+}
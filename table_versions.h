@@ -0,0 +1,69 @@
+#pragma once
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ------------------ Table Versions ------------------
+// One counter per table, bumped after every committed write group that changed a row in it.
+// The writer connection's sqlite3_update_hook records which tables a group touched, and
+// the group commit publishes them only once COMMIT has returned, so a reader that sees
+// version N is guaranteed to read data at least as new as N.
+
+class TableVersions {
+public:
+    TableVersions()
+        : epoch_(static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count())) {}
+
+    TableVersions(const TableVersions&) = delete;
+    TableVersions& operator=(const TableVersions&) = delete;
+
+    uint64_t get(const std::string& table) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = versions_.find(table);
+        return it == versions_.end() ? 0 : it->second;
+    }
+
+    // Differs between server runs, so versions from a previous process never match
+    uint64_t epoch() const { return epoch_; }
+
+    // Starts recording row changes made on `db` (the writer connection; one at a time)
+    void track(sqlite3* db) { sqlite3_update_hook(db, &TableVersions::onRowChange, this); }
+
+    // Called after the tracked connection commits: bumps every table it changed
+    void publish() {
+        if (pending_.empty()) {
+            return;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (const std::string& table : pending_) {
+            ++versions_[table];
+        }
+        pending_.clear();
+    }
+
+    // Called after the tracked connection rolls back
+    void discard() { pending_.clear(); }
+
+private:
+    static void onRowChange(void* self, int, const char*, const char* table, sqlite3_int64) {
+        auto& pending = static_cast<TableVersions*>(self)->pending_;
+        // A handful of tables per group: a linear scan avoids allocating per row
+        for (const std::string& seen : pending) {
+            if (std::strcmp(seen.c_str(), table) == 0) {
+                return;
+            }
+        }
+        pending.emplace_back(table);
+    }
+
+    const uint64_t epoch_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, uint64_t> versions_;
+    std::vector<std::string> pending_;  // tables changed by the open group, writer thread only
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include "crow.h"
+#include <sqlite3.h>
+#include <cstring>
+#include <optional>
+#include <vector>
+#include "database.h"
+#include "list_query.h"
+#include "response_format.h"
+
+// ------------------ Patient Timeline ------------------
+// A patient's appointments, bills, prescriptions and medical records as one list ordered by
+// date. Each source is a lookup on a (patientId, date...) index that returns its rows already
+// sorted, and the four cursors are merged while they are stepped, so the work is proportional
+// to the patient's history and nothing is buffered. All reads share one snapshot.
+
+struct TimelineSource {
+    const char* type;
+    // Binds the patient id as ?1; the last selected column is the sort key and is not written
+    const char* sql;
+    std::vector<ListColumn> columns;
+};
+
+inline const std::vector<TimelineSource>& timelineSources() {
+    static const std::vector<TimelineSource> sources = {
+        {"appointment",
+         "SELECT id, doctorId, date, time, date || ' ' || time FROM Appointments "
+         "WHERE patientId = ?1 ORDER BY date, time",
+         {{"id", ColumnType::Integer}, {"doctorId", ColumnType::Integer}, {"date", ColumnType::Text},
+          {"time", ColumnType::Text}}},
+        // Bills are dated by their appointment
+        {"bill",
+         "SELECT b.id, b.appointmentId, a.date, a.time, b.medicationFee, b.consultationFee, b.surgeryFee, "
+         "b.totalFee, b.isInsured, b.claimStatus, COALESCE(a.date || ' ' || a.time, '') "
+         "FROM Bills b LEFT JOIN Appointments a ON a.id = b.appointmentId "
+         "WHERE b.patientId = ?1 ORDER BY a.date, a.time, b.id",
+         {{"id", ColumnType::Integer}, {"appointmentId", ColumnType::Integer}, {"date", ColumnType::Text},
+          {"time", ColumnType::Text}, {"medicationFee", ColumnType::Real}, {"consultationFee", ColumnType::Real},
+          {"surgeryFee", ColumnType::Real}, {"totalFee", ColumnType::Real}, {"isInsured", ColumnType::Integer},
+          {"claimStatus", ColumnType::Text}}},
+        {"prescription",
+         "SELECT prescriptionId, doctorId, medication, dosage, instructions, datePrescribed, datePrescribed "
+         "FROM Prescriptions WHERE patientId = ?1 ORDER BY datePrescribed",
+         {{"prescriptionId", ColumnType::Integer}, {"doctorId", ColumnType::Integer},
+          {"medication", ColumnType::Text}, {"dosage", ColumnType::Text}, {"instructions", ColumnType::Text},
+          {"date", ColumnType::Text}}},
+        {"medicalRecord",
+         "SELECT recordId, visitDate, notes, diagnosis, visitDate FROM MedicalRecords "
+         "WHERE patientId = ?1 ORDER BY visitDate",
+         {{"recordId", ColumnType::Integer}, {"date", ColumnType::Text}, {"notes", ColumnType::Text},
+          {"diagnosis", ColumnType::Text}}},
+    };
+    return sources;
+}
+
+// {"patient": {...}, "events": [{"type": "appointment", "data": {...}}, ...]}; 404 if there is no
+// such patient
+inline crow::response patientTimeline(DbConnection& conn, long long patientId, BodyFormat format = BodyFormat::Json) {
+    ReadTransaction snapshot(conn);
+
+    return formatResponse(format, [&](auto& writer) -> std::optional<crow::response> {
+        writer.beginObject();
+        {
+            CachedStatement stmt = conn.prepare(
+                "SELECT id, name, address, medicalHistory, hasInsurance, insuranceCompany FROM Patients WHERE id = ?");
+            if (!stmt) {
+                return crow::response(500, "Failed to prepare statement");
+            }
+            sqlite3_bind_int64(stmt, 1, patientId);
+            if (sqlite3_step(stmt) != SQLITE_ROW) {
+                return crow::response(404, "Patient not found");
+            }
+            writer.key("patient");
+            writeRowObject(writer, stmt, patientListSpec().columns);
+        }
+
+        const std::vector<TimelineSource>& sources = timelineSources();
+        std::vector<CachedStatement> cursors;
+        std::vector<bool> pending;  // cursor is on a row that has not been written yet
+        cursors.reserve(sources.size());
+        for (const TimelineSource& source : sources) {
+            cursors.push_back(conn.prepare(source.sql));
+            sqlite3_stmt* stmt = cursors.back();
+            if (!stmt) {
+                return crow::response(500, "Failed to prepare statement");
+            }
+            sqlite3_bind_int64(stmt, 1, patientId);
+            int rc = sqlite3_step(stmt);
+            if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+                return crow::response(500, "Failed to read timeline");
+            }
+            pending.push_back(rc == SQLITE_ROW);
+        }
+
+        writer.key("events");
+        writer.beginArray();
+        while (true) {
+            // Earliest pending row; on equal dates the source order above decides
+            int next = -1;
+            const char* nextKey = nullptr;
+            for (size_t i = 0; i < cursors.size(); ++i) {
+                if (!pending[i]) {
+                    continue;
+                }
+                int keyColumn = static_cast<int>(sources[i].columns.size());
+                const char* key = reinterpret_cast<const char*>(sqlite3_column_text(cursors[i], keyColumn));
+                key = key ? key : "";
+                if (next < 0 || std::strcmp(key, nextKey) < 0) {
+                    next = static_cast<int>(i);
+                    nextKey = key;
+                }
+            }
+            if (next < 0) {
+                break;
+            }
+
+            sqlite3_stmt* stmt = cursors[next];
+            writer.beginObject();
+            writer.key("type");
+            writer.value(sources[next].type);
+            writer.key("data");
+            writeRowObject(writer, stmt, sources[next].columns);
+            writer.endObject();
+
+            int rc = sqlite3_step(stmt);
+            if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+                return crow::response(500, "Failed to read timeline");
+            }
+            pending[next] = rc == SQLITE_ROW;
+        }
+        writer.endArray();
+        writer.endObject();
+        return std::nullopt;
+    });
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <string_view>
+#include <system_error>
+
+// ------------------ Input Validation ------------------
+// Hand-written parsers for request fields. They work on string_views, never allocate, and
+// reject anything that is not exactly the expected shape (no leading spaces, signs or
+// trailing characters).
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+constexpr int digitsValue(std::string_view text, size_t pos, size_t count) {
+    int value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        value = value * 10 + (text[i] - '0');
+    }
+    return value;
+}
+
+constexpr bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+constexpr int daysInMonth(int year, int month) {
+    constexpr int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return month == 2 && isLeapYear(year) ? 29 : days[month - 1];
+}
+
+// "YYYY-MM-DD" naming a real calendar day (so 2025-02-29 and 2025-13-01 are rejected)
+constexpr bool parseDate(std::string_view date, int& year, int& month, int& day) {
+    if (date.size() != 10 || date[4] != '-' || date[7] != '-') {
+        return false;
+    }
+    for (size_t i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        if (!isDigit(date[i])) {
+            return false;
+        }
+    }
+    year = digitsValue(date, 0, 4);
+    month = digitsValue(date, 5, 2);
+    day = digitsValue(date, 8, 2);
+    return year >= 1 && month >= 1 && month <= 12 && day >= 1 && day <= daysInMonth(year, month);
+}
+
+// "HH:MM" on a 24-hour clock, as minutes since midnight
+constexpr bool parseClockTime(std::string_view time, int& minutes) {
+    if (time.size() != 5 || time[2] != ':' || !isDigit(time[0]) || !isDigit(time[1]) ||
+        !isDigit(time[3]) || !isDigit(time[4])) {
+        return false;
+    }
+    int hour = digitsValue(time, 0, 2);
+    int minute = digitsValue(time, 3, 2);
+    if (hour > 23 || minute > 59) {
+        return false;
+    }
+    minutes = hour * 60 + minute;
+    return true;
+}
+
+constexpr bool isValidDate(std::string_view date) {
+    int year = 0, month = 0, day = 0;
+    return parseDate(date, year, month, day);
+}
+
+// Appointments run from 09:00 to 17:00 in 10-minute increments
+constexpr bool isValidAppointmentTime(std::string_view time) {
+    int minutes = 0;
+    return parseClockTime(time, minutes) && minutes >= 9 * 60 && minutes <= 17 * 60 && minutes % 10 == 0;
+}
+
+static_assert(isValidDate("2024-02-29") && !isValidDate("2025-02-29") && !isValidDate("2025-04-31"));
+static_assert(isValidAppointmentTime("09:00") && isValidAppointmentTime("17:00") && !isValidAppointmentTime("17:10"));
+static_assert(!isValidAppointmentTime("09:60") && !isValidAppointmentTime("9:00") && !isValidAppointmentTime("12:05"));
+
+// Whole decimal integer, optionally negative, that fits in T
+template <typename T>
+bool parseIntegerParam(std::string_view text, T& value) {
+    if (text.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Finite decimal number such as "12", "-3.5" or "1e3"
+inline bool parseDecimalParam(std::string_view text, double& value) {
+    if (text.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size() && std::isfinite(value);
+}
+
+// Query-string forms; a missing parameter (nullptr) is invalid
+inline bool parseInt64Param(const char* text, long long& value) {
+    return text && parseIntegerParam(std::string_view(text), value);
+}
+
+inline bool parseIntParam(const char* text, int& value) {
+    return text && parseIntegerParam(std::string_view(text), value);
+}
+
+inline bool parseDoubleParam(const char* text, double& value) {
+    return text && parseDecimalParam(std::string_view(text), value);
+}
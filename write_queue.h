@@ -0,0 +1,243 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "database.h"
+#include "table_versions.h"
+
+// ------------------ Group Commit Write Queue ------------------
+// Every mutating request is handed to one writer thread instead of committing on its own
+// connection. Jobs that arrive while the previous group is committing (or within the
+// configured window) run back to back inside a single BEGIN IMMEDIATE ... COMMIT, each in
+// its own savepoint, so one commit, and one WAL sync when synchronous requires it, is
+// paid per group rather than per request. Producers push with a lock-free stack; the writer
+// takes the whole stack at once and reverses it to restore arrival order.
+
+class WriteQueue {
+public:
+    // Runs on the writer thread inside the group transaction. Returning false (or throwing)
+    // rolls back this job's savepoint only; the rest of the group still commits.
+    using Work = std::function<bool(DbConnection&)>;
+
+    // `versions`, if given, is bumped for every table a committed group changed
+    WriteQueue(ConnectionPool& pool, const StorageProfile& profile, TableVersions* versions = nullptr)
+        : pool_(pool),
+          versions_(versions),
+          window_(std::chrono::microseconds(profile.groupCommitWindowUs)),
+          maxJobs_(profile.groupCommitMaxJobs > 0 ? profile.groupCommitMaxJobs : 1),
+          thread_([this] { run(); }) {}
+
+    WriteQueue(const WriteQueue&) = delete;
+    WriteQueue& operator=(const WriteQueue&) = delete;
+
+    ~WriteQueue() { stop(); }
+
+    // The future becomes true once the group containing the job has committed, or false if the
+    // group transaction (or the job's own savepoint) could not be started, or the group could
+    // not be committed (its changes are then rolled back).
+    std::future<bool> submit(Work work) {
+        Job* job = new Job;
+        job->work = std::move(work);
+        std::future<bool> done = job->done.get_future();
+        if (stopping_.load()) {
+            job->done.set_value(false);
+            delete job;
+            return done;
+        }
+
+        job->next = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(job->next, job)) {
+        }
+        // stop() may have taken its last look at the stack just before the push; whoever
+        // exchanges the stack away first answers the jobs on it
+        if (stopped_.load()) {
+            failQueued();
+            return done;
+        }
+        // Only pay for the mutex when the writer is (about to be) asleep
+        if (sleeping_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake_.notify_one();
+        }
+        return done;
+    }
+
+    // Commits whatever is still queued, then joins the writer thread. Jobs that slip in after
+    // the writer's final drain are answered false rather than left without a result.
+    void stop() {
+        if (stopping_.exchange(true)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake_.notify_one();
+        }
+        thread_.join();
+        stopped_.store(true);
+        failQueued();
+    }
+
+    long long committedGroups() const { return committedGroups_.load(std::memory_order_relaxed); }
+    long long committedJobs() const { return committedJobs_.load(std::memory_order_relaxed); }
+
+private:
+    struct Job {
+        Work work;
+        std::promise<bool> done;
+        std::exception_ptr error;
+        bool ran = false;  // its savepoint opened and the work was called
+        Job* next = nullptr;
+    };
+
+    // Moves everything pushed so far onto the end of the pending FIFO
+    void drain() {
+        Job* stack = head_.exchange(nullptr);
+        Job* reversed = nullptr;
+        Job* last = stack;
+        while (stack) {
+            Job* next = stack->next;
+            stack->next = reversed;
+            reversed = stack;
+            stack = next;
+        }
+        if (!reversed) {
+            return;
+        }
+        if (pendingTail_) {
+            pendingTail_->next = reversed;
+        } else {
+            pendingHead_ = reversed;
+        }
+        pendingTail_ = last;
+    }
+
+    // After the writer has exited: answers false for every job still on the stack
+    void failQueued() {
+        Job* job = head_.exchange(nullptr);
+        while (job) {
+            Job* next = job->next;
+            job->done.set_value(false);
+            delete job;
+            job = next;
+        }
+    }
+
+    void run() {
+        DbConnection& conn = pool_.local();
+        if (versions_) {
+            versions_->track(conn.handle());
+        }
+        while (true) {
+            drain();
+            if (!pendingHead_) {
+                if (stopping_.load()) {
+                    return;
+                }
+                std::unique_lock<std::mutex> lock(mutex_);
+                sleeping_.store(true);
+                wake_.wait(lock, [this] { return head_.load() != nullptr || stopping_.load(); });
+                sleeping_.store(false);
+                continue;
+            }
+            // Give concurrent requests a moment to join this group
+            if (window_.count() > 0 && !stopping_.load()) {
+                std::this_thread::sleep_for(window_);
+                drain();
+            }
+            commitGroup(conn);
+        }
+    }
+
+    void commitGroup(DbConnection& conn) {
+        // Detach up to maxJobs_ from the front of the pending list
+        Job* group = pendingHead_;
+        Job* tail = group;
+        int count = 1;
+        while (tail->next && count < maxJobs_) {
+            tail = tail->next;
+            ++count;
+        }
+        pendingHead_ = tail->next;
+        if (!pendingHead_) {
+            pendingTail_ = nullptr;
+        }
+        tail->next = nullptr;
+
+        bool committed = false;
+        {
+            Transaction txn(conn);
+            if (txn.ok()) {
+                for (Job* job = group; job; job = job->next) {
+                    Transaction savepoint(conn);
+                    bool keep = false;
+                    try {
+                        job->ran = savepoint.ok();
+                        keep = job->ran && job->work(conn);
+                    } catch (...) {
+                        job->error = std::current_exception();
+                    }
+                    if (keep) {
+                        savepoint.commit();
+                    } else {
+                        savepoint.rollback();
+                    }
+                }
+                committed = txn.commit();
+            }
+            if (!committed) {
+                std::cerr << "Group commit of " << count << " writes failed: " << sqlite3_errmsg(conn.handle()) << std::endl;
+            }
+        }
+        if (committed) {
+            committedGroups_.fetch_add(1, std::memory_order_relaxed);
+            committedJobs_.fetch_add(count, std::memory_order_relaxed);
+        }
+        if (versions_) {
+            if (committed) {
+                versions_->publish();
+            } else {
+                versions_->discard();
+            }
+        }
+
+        // Requests are only answered once their group has committed (or definitely failed).
+        // A job whose savepoint could not be opened never ran, so it fails whatever the group did.
+        while (group) {
+            Job* next = group->next;
+            if (group->error) {
+                group->done.set_exception(group->error);
+            } else {
+                group->done.set_value(committed && group->ran);
+            }
+            delete group;
+            group = next;
+        }
+    }
+
+    ConnectionPool& pool_;
+    TableVersions* versions_;
+    std::chrono::microseconds window_;
+    int maxJobs_;
+
+    std::atomic<Job*> head_{nullptr};
+    Job* pendingHead_ = nullptr;  // writer thread only
+    Job* pendingTail_ = nullptr;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> stopped_{false};  // writer thread joined
+
+    std::atomic<long long> committedGroups_{0};
+    std::atomic<long long> committedJobs_{0};
+
+    std::thread thread_;  // last, so it starts after everything above is initialized
+};